@@ -0,0 +1,379 @@
+// autolykos2_cpu_miner.cpp
+
+#include "autolykos2_cpu_miner.h"
+#include "autolykos2_cpu_pipeline.h"
+#include "autolykos2_cpu_stages.h"
+#include "autolykos2_params.h"
+#include "cpu_topology.h"
+#include "huge_alloc.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+void autolykos2_cpu_hash(
+    const uint32_t* dataset,
+    uint32_t table_bits,
+    const uint8_t* header,
+    uint64_t nonce,
+    uint8_t* out_hash
+) {
+    uint8_t hash1[32];
+    uint32_t r[NUM_SIZE_32];
+    uint32_t ind[K_LEN];
+    seed_stage(header, nonce, hash1, r);
+    index_stage<K_LEN>(r, (uint32_t)((1ull << table_bits) - 1), ind);
+
+    // Only the low 64 bits of the sum reach the final hash
+    uint64_t sum = 0;
+    for (int k = 0; k < K_LEN; ++k) sum += dataset[ind[k]];
+    final_stage(hash1, sum, out_hash);
+}
+
+void autolykos2_cpu_hash_ondemand(
+    const uint8_t* seed,
+    uint32_t table_bits,
+    const uint8_t* header,
+    uint64_t nonce,
+    uint8_t* out_hash
+) {
+    uint8_t hash1[32];
+    uint32_t r[NUM_SIZE_32];
+    uint32_t ind[K_LEN];
+    seed_stage(header, nonce, hash1, r);
+    index_stage<K_LEN>(r, (uint32_t)((1ull << table_bits) - 1), ind);
+
+    uint64_t sum = 0;
+    for (int k = 0; k < K_LEN; ++k) sum += element_stage(seed, ind[k]);
+    final_stage(hash1, sum, out_hash);
+}
+
+// Persistent worker pool. Workers are spread over NUMA nodes in proportion
+// to each node's CPU count and pinned to their node, and every node with
+// workers holds its own dataset replica so gathers stay node-local.
+struct autolykos2_cpu_ctx {
+    uint32_t table_bits;
+    std::atomic<uint32_t> table_size{0};            // Elements the current job indexes, <= 2^table_bits
+    std::atomic<autolykos2_scan_fn> scan{nullptr};  // Swapped by set_interleave, set_isa and set_table_size
+    uint32_t lanes = AUTOLYKOS2_CPU_DEFAULT_INTERLEAVE;
+    const char* isa = nullptr;                      // NULL = best available
+    std::string selected;                           // Last pipeline logged, as "isa/lanes/table"
+    std::atomic<int> active_workers{0};             // Workers that take part in mine
+    std::vector<NumaNode> nodes;
+    std::vector<uint32_t*> replicas;   // Indexed like nodes, NULL for nodes without workers
+    std::vector<HugeAllocation> replica_mem;
+    std::vector<int> worker_node;      // Node index of each worker
+    std::vector<std::thread> workers;
+
+    std::mutex dispatch_mtx;           // One task at a time per context
+    std::mutex mtx;
+    std::condition_variable cv_task;
+    std::condition_variable cv_done;
+    std::function<void(int)> task;
+    uint64_t task_seq = 0;
+    int pending = 0;
+    bool shutdown = false;
+};
+
+// Default is one worker per CPU the process may run on
+static int resolve_threads(int threads, size_t allowed_cpus) {
+    if (threads > 0) return threads;
+    return allowed_cpus ? (int)allowed_cpus : 1;
+}
+
+static void worker_loop(autolykos2_cpu_ctx* ctx, int worker) {
+    const NumaNode& node = ctx->nodes[ctx->worker_node[worker]];
+    if (!pin_current_thread(node.cpus)) {
+        fprintf(stderr, "[CPU] Could not pin worker %d to node %d, running unpinned\n", worker, node.id);
+    }
+    uint64_t seen = 0;
+    for (;;) {
+        std::function<void(int)> task;
+        {
+            std::unique_lock<std::mutex> lock(ctx->mtx);
+            ctx->cv_task.wait(lock, [&] { return ctx->shutdown || ctx->task_seq != seen; });
+            if (ctx->shutdown) return;
+            seen = ctx->task_seq;
+            task = ctx->task;
+        }
+        task(worker);
+        std::lock_guard<std::mutex> lock(ctx->mtx);
+        if (--ctx->pending == 0) ctx->cv_done.notify_all();
+    }
+}
+
+// Runs fn(worker) on every worker and waits for all of them
+static void run_on_workers(autolykos2_cpu_ctx* ctx, const std::function<void(int)>& fn) {
+    std::lock_guard<std::mutex> dispatch(ctx->dispatch_mtx);
+    std::unique_lock<std::mutex> lock(ctx->mtx);
+    ctx->task = fn;
+    ctx->pending = (int)ctx->workers.size();
+    ctx->task_seq++;
+    ctx->cv_task.notify_all();
+    ctx->cv_done.wait(lock, [&] { return ctx->pending == 0; });
+    ctx->task = nullptr;
+}
+
+autolykos2_cpu_ctx* autolykos2_cpu_create(int threads, uint32_t table_bits) {
+    if (table_bits == 0) table_bits = AUTOLYKOS2_N;
+    if (table_bits > 31) {
+        fprintf(stderr, "Invalid CPU table size: 2^%u\n", table_bits);
+        return nullptr;
+    }
+    autolykos2_cpu_ctx* ctx = new autolykos2_cpu_ctx{};
+    ctx->table_bits = table_bits;
+    ctx->table_size = 1u << table_bits;
+    ctx->scan = autolykos2_select_pipeline(ctx->table_size, K_LEN, ctx->lanes).scan;
+    ctx->nodes = detect_numa_nodes();
+
+    // Assign workers evenly over the flattened (node, cpu) list
+    std::vector<int> cpu_node;
+    for (size_t n = 0; n < ctx->nodes.size(); ++n)
+        cpu_node.insert(cpu_node.end(), ctx->nodes[n].cpus.size(), (int)n);
+    const int nworkers = resolve_threads(threads, cpu_node.size());
+    for (int i = 0; i < nworkers; ++i)
+        ctx->worker_node.push_back(cpu_node[(size_t)i * cpu_node.size() / nworkers]);
+
+    // Pages are placed on first touch by the pinned workers during generation
+    size_t dataset_size = ((size_t)1 << table_bits) * sizeof(uint32_t);
+    ctx->replicas.assign(ctx->nodes.size(), nullptr);
+    ctx->replica_mem.resize(ctx->nodes.size());
+    for (int n : ctx->worker_node) {
+        if (ctx->replicas[n]) continue;
+        ctx->replica_mem[n] = huge_alloc(dataset_size);
+        ctx->replicas[n] = (uint32_t*)ctx->replica_mem[n].ptr;
+        if (!ctx->replicas[n]) {
+            fprintf(stderr, "Failed to allocate host dataset memory\n");
+            autolykos2_cpu_destroy(ctx);
+            return nullptr;
+        }
+        printf("[CPU] Node %d dataset: %.1f MB on %s pages\n", ctx->nodes[n].id,
+               dataset_size / 1048576.0, ctx->replica_mem[n].kind);
+    }
+
+    for (int i = 0; i < nworkers; ++i) ctx->workers.emplace_back(worker_loop, ctx, i);
+    ctx->active_workers = nworkers;
+    size_t replica_count = ctx->nodes.size() - std::count(ctx->replicas.begin(), ctx->replicas.end(), nullptr);
+    printf("[CPU] %zu NUMA node(s), %d worker(s), %zu dataset replica(s)\n",
+           ctx->nodes.size(), nworkers, replica_count);
+    return ctx;
+}
+
+bool autolykos2_cpu_generate_dataset(autolykos2_cpu_ctx* ctx, const uint8_t* seed) {
+    if (!ctx) {
+        fprintf(stderr, "Miner not initialized\n");
+        return false;
+    }
+    const uint32_t total_elements = 1u << ctx->table_bits;
+    const uint32_t chunk_size = std::min<uint32_t>(1024 * 1024, total_elements);
+    const uint32_t chunks = (total_elements + chunk_size - 1) / chunk_size;
+    std::atomic<uint32_t> next_chunk{0};
+    std::atomic<uint32_t> done_chunks{0};
+    std::vector<int> chunk_owner(chunks, -1);
+
+    // Phase 1: every worker hashes chunks into its own node's replica
+    run_on_workers(ctx, [&](int worker) {
+        const int node = ctx->worker_node[worker];
+        uint32_t* dataset = ctx->replicas[node];
+        for (;;) {
+            uint32_t chunk = next_chunk.fetch_add(1);
+            if (chunk >= chunks) break;
+            uint32_t start = chunk * chunk_size;
+            uint32_t end = (total_elements - start > chunk_size) ? start + chunk_size : total_elements;
+            for (uint32_t idx = start; idx < end; ++idx) dataset[idx] = element_stage(seed, idx);
+            chunk_owner[chunk] = node;
+            uint32_t done = done_chunks.fetch_add(1) + 1;
+            if (done % 10 == 0) {
+                printf("[CPU] Dataset generation: %.2f%%\n", 100.0f * done / chunks);
+            }
+        }
+    });
+
+    // Phase 2: each node copies the chunks built elsewhere into its replica
+    std::vector<std::atomic<uint32_t>> next_copy(ctx->nodes.size());
+    for (auto& c : next_copy) c = 0;
+    run_on_workers(ctx, [&](int worker) {
+        const int node = ctx->worker_node[worker];
+        uint32_t* dataset = ctx->replicas[node];
+        for (;;) {
+            uint32_t chunk = next_copy[node].fetch_add(1);
+            if (chunk >= chunks) break;
+            int owner = chunk_owner[chunk];
+            if (owner == node) continue;
+            uint32_t start = chunk * chunk_size;
+            uint32_t count = std::min(chunk_size, total_elements - start);
+            memcpy(dataset + start, ctx->replicas[owner] + start, count * sizeof(uint32_t));
+        }
+    });
+    printf("[CPU] Dataset generation completed\n");
+
+    // Only written memory shows whether the kernel honoured MADV_HUGEPAGE
+    for (size_t n = 0; n < ctx->replica_mem.size(); ++n) {
+        HugeAllocation& mem = ctx->replica_mem[n];
+        if (!mem.ptr || strncmp(mem.kind, "thp", 3) != 0) continue;
+        size_t huge = huge_confirm_thp(mem);
+        printf("[CPU] Node %d dataset: %.1f of %.1f MB on transparent huge pages (%s)\n", ctx->nodes[n].id,
+               huge / 1048576.0, mem.mapped_size / 1048576.0, mem.kind);
+    }
+    return true;
+}
+
+bool autolykos2_cpu_profile_stages(
+    const autolykos2_cpu_ctx* ctx,
+    const uint8_t* header,
+    uint32_t nonces,
+    double* stage_ns
+) {
+    if (!ctx || nonces == 0) return false;
+    const uint32_t* dataset = nullptr;
+    for (const uint32_t* r : ctx->replicas) {
+        if (r) { dataset = r; break; }
+    }
+    if (!dataset) return false;
+
+    const uint32_t mask = (uint32_t)((1ull << ctx->table_bits) - 1);
+    std::vector<uint8_t> hash1((size_t)nonces * 32);
+    std::vector<uint32_t> r((size_t)nonces * NUM_SIZE_32);
+    std::vector<uint32_t> ind((size_t)nonces * K_LEN);
+    std::vector<uint64_t> sums(nonces);
+    uint8_t out[32];
+    uint8_t sink = 0;
+
+    auto timed = [&](auto&& stage) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < nonces; ++n) stage(n);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / nonces;
+    };
+    stage_ns[0] = timed([&](uint32_t n) { seed_stage(header, n, &hash1[32 * n], &r[NUM_SIZE_32 * n]); });
+    stage_ns[1] = timed([&](uint32_t n) { index_stage<K_LEN>(&r[NUM_SIZE_32 * n], mask, &ind[K_LEN * n]); });
+    stage_ns[2] = timed([&](uint32_t n) {
+        uint64_t sum = 0;
+        for (int k = 0; k < K_LEN; ++k) sum += dataset[ind[K_LEN * n + k]];
+        sums[n] = sum;
+    });
+    stage_ns[3] = timed([&](uint32_t n) {
+        final_stage(&hash1[32 * n], sums[n], out);
+        sink ^= out[0];
+    });
+    // Keeps the final stage from being optimized away
+    volatile uint8_t keep = sink;
+    (void)keep;
+    return true;
+}
+
+bool autolykos2_meets_target(const uint8_t* hash, const uint8_t* target_boundary) {
+    return meets_target(hash, target_boundary);
+}
+
+bool autolykos2_cpu_mine(
+    autolykos2_cpu_ctx* ctx,
+    const uint8_t* header,
+    uint64_t start_nonce,
+    uint32_t nonce_count,
+    const uint8_t* target_boundary,
+    uint64_t* found_nonce,
+    uint8_t* found_hash,
+    bool* found
+) {
+    if (!ctx) {
+        fprintf(stderr, "Miner not initialized\n");
+        return false;
+    }
+    std::atomic<bool> found_flag{false};
+    const int workers = ctx->active_workers.load();
+    const autolykos2_scan_fn scan = ctx->scan.load();
+    const uint32_t table_size = ctx->table_size.load();
+
+    run_on_workers(ctx, [&](int worker) {
+        if (worker >= workers) return;
+        const uint32_t* dataset = ctx->replicas[ctx->worker_node[worker]];
+        uint64_t begin = start_nonce + (uint64_t)nonce_count * worker / workers;
+        uint64_t end = start_nonce + (uint64_t)nonce_count * (worker + 1) / workers;
+        scan(dataset, table_size, header, begin, end, target_boundary,
+             &found_flag, found_nonce, found_hash);
+    });
+
+    *found = found_flag.load();
+    return true;
+}
+
+void autolykos2_cpu_destroy(autolykos2_cpu_ctx* ctx) {
+    if (!ctx) return;
+    {
+        std::lock_guard<std::mutex> lock(ctx->mtx);
+        ctx->shutdown = true;
+    }
+    ctx->cv_task.notify_all();
+    for (auto& th : ctx->workers) th.join();
+    for (auto& mem : ctx->replica_mem) huge_free(mem);
+    delete ctx;
+}
+
+// Swaps in the scan for the current table size, lanes and ISA, logging
+// only real changes
+static void select_scan(autolykos2_cpu_ctx* ctx) {
+    const uint32_t table_size = ctx->table_size.load();
+    Autolykos2Pipeline p = autolykos2_select_pipeline(table_size, K_LEN, ctx->lanes, ctx->isa);
+    ctx->scan = p.scan;
+    std::string selected = std::string(p.isa) + "/" + std::to_string(p.lanes) + "/" + std::to_string(table_size);
+    if (selected == ctx->selected) return;
+    ctx->selected = selected;
+    if (p.table_bits) {
+        printf("[CPU] Pipeline: %s, 2^%u table, K %u, %u lanes\n", p.isa, p.table_bits, p.k, p.lanes);
+    } else {
+        printf("[CPU] Pipeline: %s, generic %u-element table, K %u, %u lanes\n", p.isa, table_size, p.k, p.lanes);
+    }
+}
+
+uint32_t autolykos2_cpu_set_table_size(autolykos2_cpu_ctx* ctx, uint32_t elements) {
+    if (!ctx) return 0;
+    const uint32_t dataset = 1u << ctx->table_bits;
+    elements = elements ? std::min(elements, dataset) : dataset;
+    if (elements != ctx->table_size.load()) {
+        ctx->table_size = elements;
+        select_scan(ctx);
+    }
+    return elements;
+}
+
+void autolykos2_cpu_set_interleave(autolykos2_cpu_ctx* ctx, uint32_t depth) {
+    if (!ctx) return;
+    ctx->lanes = depth ? depth : AUTOLYKOS2_CPU_DEFAULT_INTERLEAVE;
+    select_scan(ctx);
+}
+
+bool autolykos2_cpu_set_isa(autolykos2_cpu_ctx* ctx, const char* isa) {
+    if (!ctx) return false;
+    if (isa && !autolykos2_pipeline_isa_supported(isa)) return false;
+    ctx->isa = isa ? (strcmp(isa, "avx2") == 0 ? "avx2" : "scalar") : nullptr;
+    select_scan(ctx);
+    return true;
+}
+
+int autolykos2_cpu_set_active_threads(autolykos2_cpu_ctx* ctx, int threads) {
+    if (!ctx) return 0;
+    threads = std::max(1, std::min(threads, (int)ctx->workers.size()));
+    ctx->active_workers = threads;
+    return threads;
+}
+
+int autolykos2_cpu_thread_count(const autolykos2_cpu_ctx* ctx) {
+    return ctx ? (int)ctx->workers.size() : 0;
+}
+
+size_t autolykos2_cpu_page_size(const autolykos2_cpu_ctx* ctx) {
+    if (!ctx) return 0;
+    size_t page = 0;
+    for (const auto& mem : ctx->replica_mem) {
+        if (mem.ptr && (page == 0 || mem.page_size < page)) page = mem.page_size;
+    }
+    return page;
+}
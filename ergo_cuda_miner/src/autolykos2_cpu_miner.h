@@ -0,0 +1,179 @@
+#ifndef AUTOLYKOS2_CPU_MINER_H
+#define AUTOLYKOS2_CPU_MINER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUTOLYKOS2_CPU_DEFAULT_INTERLEAVE 8
+#define AUTOLYKOS2_CPU_MAX_INTERLEAVE 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * CPU miner state (host dataset and worker configuration).
+ * Contexts are independent, so several can mine concurrently.
+ */
+typedef struct autolykos2_cpu_ctx autolykos2_cpu_ctx;
+
+/**
+ * Create a CPU miner context
+ * @param threads Worker threads, spread over NUMA nodes and pinned (0 = all hardware threads)
+ * @param table_bits log2 of the dataset size (0 = AUTOLYKOS2_N)
+ * @return new context, or NULL on failure
+ */
+autolykos2_cpu_ctx* autolykos2_cpu_create(int threads, uint32_t table_bits);
+
+/**
+ * Generate the Autolykos2 dataset in host memory
+ * @param ctx CPU miner context
+ * @param seed 32-byte seed for dataset generation
+ * @return true on success, false on failure
+ */
+bool autolykos2_cpu_generate_dataset(autolykos2_cpu_ctx* ctx, const uint8_t* seed);
+
+/**
+ * Mine a nonce range on the CPU
+ * @param ctx CPU miner context
+ * @param header 76-byte block header
+ * @param start_nonce Starting nonce value
+ * @param nonce_count Number of nonces to test
+ * @param target_boundary 32-byte little-endian target boundary
+ * @param found_nonce Output: found nonce if successful
+ * @param found_hash Output: hash of the found solution
+ * @param found Output: true if valid nonce found
+ * @return true on success, false on failure
+ */
+bool autolykos2_cpu_mine(
+    autolykos2_cpu_ctx* ctx,
+    const uint8_t* header,
+    uint64_t start_nonce,
+    uint32_t nonce_count,
+    const uint8_t* target_boundary,
+    uint64_t* found_nonce,
+    uint8_t* found_hash,
+    bool* found
+);
+
+/**
+ * Free the host dataset and context
+ * @param ctx CPU miner context (may be NULL)
+ */
+void autolykos2_cpu_destroy(autolykos2_cpu_ctx* ctx);
+
+/**
+ * Set how many nonces each worker hashes together. Their dataset reads
+ * are prefetched as one group so cache misses overlap. Also reselects the
+ * compile-time specialized scan for this group width and table size.
+ * @param ctx CPU miner context
+ * @param depth Nonces per group (0 = default, capped at AUTOLYKOS2_CPU_MAX_INTERLEAVE,
+ *              rounded down to a power of two)
+ */
+void autolykos2_cpu_set_interleave(autolykos2_cpu_ctx* ctx, uint32_t depth);
+
+/**
+ * Set the table size the following autolykos2_cpu_mine calls index, for a
+ * job whose table is smaller than the dataset: indices are reduced modulo
+ * elements over the dataset's first elements. Reselects the scan
+ * specialized for that size, or the generic one when there is none.
+ * @param ctx CPU miner context
+ * @param elements Table size (0 or anything above the dataset = the whole dataset)
+ * @return table size in effect, 0 if ctx is NULL
+ */
+uint32_t autolykos2_cpu_set_table_size(autolykos2_cpu_ctx* ctx, uint32_t elements);
+
+/**
+ * Choose the SIMD build of the hashing pipeline
+ * @param ctx CPU miner context
+ * @param isa "scalar", "avx2", or NULL for the best the CPU supports
+ * @return false if isa is unknown or unsupported on this CPU
+ */
+bool autolykos2_cpu_set_isa(autolykos2_cpu_ctx* ctx, const char* isa);
+
+/**
+ * Limit how many workers hash in autolykos2_cpu_mine. The rest stay parked.
+ * @param ctx CPU miner context
+ * @param threads Active workers (clamped to 1..worker count)
+ * @return active workers after clamping, 0 if ctx is NULL
+ */
+int autolykos2_cpu_set_active_threads(autolykos2_cpu_ctx* ctx, int threads);
+
+/**
+ * Number of workers in the pool
+ * @param ctx CPU miner context
+ * @return worker count, 0 if ctx is NULL
+ */
+int autolykos2_cpu_thread_count(const autolykos2_cpu_ctx* ctx);
+
+/**
+ * Page size backing the dataset replicas (smallest across nodes)
+ * @param ctx CPU miner context
+ * @return page size in bytes, e.g. 4096, 2 MB or 1 GB
+ */
+size_t autolykos2_cpu_page_size(const autolykos2_cpu_ctx* ctx);
+
+/**
+ * Time the hashing stages separately with the scalar reference on the
+ * calling thread. Each stage runs over every nonce before the next one
+ * starts, so the numbers are isolated costs without pipeline overlap.
+ * @param ctx CPU miner context with a generated dataset
+ * @param header 76-byte block header
+ * @param nonces Nonces to hash
+ * @param stage_ns Output: mean ns per nonce of the seed, index, gather and final stages
+ * @return false if ctx is NULL or nonces is 0
+ */
+bool autolykos2_cpu_profile_stages(
+    const autolykos2_cpu_ctx* ctx,
+    const uint8_t* header,
+    uint32_t nonces,
+    double* stage_ns
+);
+
+/**
+ * Scalar reference hash of one nonce, bit-identical to the CUDA kernel
+ * @param dataset Dataset of (1 << table_bits) elements
+ * @param table_bits log2 of the dataset size
+ * @param header 76-byte block header
+ * @param nonce Nonce to hash
+ * @param out_hash Output: 32-byte final hash
+ */
+void autolykos2_cpu_hash(
+    const uint32_t* dataset,
+    uint32_t table_bits,
+    const uint8_t* header,
+    uint64_t nonce,
+    uint8_t* out_hash
+);
+
+/**
+ * Reference hash of one nonce without a dataset: the 64 elements it reads
+ * are derived from the seed on demand. Slow, but needs no table memory.
+ * @param seed 32-byte dataset seed
+ * @param table_bits log2 of the dataset size
+ * @param header 76-byte block header
+ * @param nonce Nonce to hash
+ * @param out_hash Output: 32-byte final hash
+ */
+void autolykos2_cpu_hash_ondemand(
+    const uint8_t* seed,
+    uint32_t table_bits,
+    const uint8_t* header,
+    uint64_t nonce,
+    uint8_t* out_hash
+);
+
+/**
+ * Compare a hash against a target boundary
+ * @param hash 32-byte hash, little-endian
+ * @param target_boundary 32-byte target, little-endian
+ * @return true if hash < target
+ */
+bool autolykos2_meets_target(const uint8_t* hash, const uint8_t* target_boundary);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // AUTOLYKOS2_CPU_MINER_H
@@ -0,0 +1,46 @@
+// autolykos2_cpu_pipeline.cpp
+#include "autolykos2_cpu_pipeline_impl.h"
+#include <cstring>
+
+autolykos2_scan_fn autolykos2_pipeline_scalar(uint32_t table_bits, uint32_t k, uint32_t lanes) {
+    return lookup_scan(table_bits, k, lanes);
+}
+
+static bool cpu_has_avx2() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+bool autolykos2_pipeline_isa_supported(const char* isa) {
+    if (!isa) return false;
+    if (strcmp(isa, "scalar") == 0) return true;
+    if (strcmp(isa, "avx2") == 0) return cpu_has_avx2();
+    return false;
+}
+
+Autolykos2Pipeline autolykos2_select_pipeline(uint32_t table_size, uint32_t k, uint32_t lanes, const char* isa) {
+    Autolykos2Pipeline p;
+    if (lanes == 0) lanes = 1;
+    if (lanes > AUTOLYKOS2_CPU_MAX_INTERLEAVE) lanes = AUTOLYKOS2_CPU_MAX_INTERLEAVE;
+    while (lanes & (lanes - 1)) lanes &= lanes - 1;
+    p.lanes = lanes;
+
+    const bool avx2 = isa ? strcmp(isa, "avx2") == 0 && cpu_has_avx2() : cpu_has_avx2();
+    autolykos2_scan_fn (*lookup)(uint32_t, uint32_t, uint32_t) =
+        avx2 ? autolykos2_pipeline_avx2 : autolykos2_pipeline_scalar;
+    p.isa = avx2 ? "avx2" : "scalar";
+    p.k = k;
+
+    // Only power-of-two tables have a specialization
+    uint32_t table_bits = table_size && (table_size & (table_size - 1)) == 0 ? __builtin_ctz(table_size) : 0;
+    p.scan = table_bits ? lookup(table_bits, k, lanes) : nullptr;
+    if (p.scan) {
+        p.table_bits = table_bits;
+    } else {
+        p.scan = lookup(0, k, lanes);
+    }
+    return p;
+}
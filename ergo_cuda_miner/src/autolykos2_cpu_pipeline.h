@@ -0,0 +1,52 @@
+// autolykos2_cpu_pipeline.h
+#ifndef AUTOLYKOS2_CPU_PIPELINE_H
+#define AUTOLYKOS2_CPU_PIPELINE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Hashes nonces [begin, end) against the first table_size elements of the
+// dataset, reducing indices modulo table_size. The range is taken modulo
+// 2^64, so end is 0 when it includes the last nonce.
+// Like the CUDA kernel the whole range is scanned; the first hit to claim
+// found_flag writes found_nonce and found_hash.
+typedef void (*autolykos2_scan_fn)(
+    const uint32_t* dataset,
+    uint32_t table_size,
+    const uint8_t* header,
+    uint64_t begin,
+    uint64_t end,
+    const uint8_t* target_boundary,
+    std::atomic<bool>* found_flag,
+    uint64_t* found_nonce,
+    uint8_t* found_hash
+);
+
+struct Autolykos2Pipeline {
+    autolykos2_scan_fn scan = nullptr;
+    uint32_t table_bits = 0;  // log2 of the table size compiled in, 0 = runtime table size
+    uint32_t k = 0;           // Indices per nonce compiled in
+    uint32_t lanes = 1;       // Nonces hashed together per group
+    const char* isa = "scalar";
+};
+
+// Picks the most specialized scan for a table of table_size elements, K
+// indices per nonce and this group width on the running CPU. Called for
+// every job whose table size differs from the last one. lanes is rounded
+// down to a power of two between 1 and AUTOLYKOS2_CPU_MAX_INTERLEAVE.
+// Table sizes without a specialization fall back to a scan that reduces
+// indices with the runtime table size; scan is NULL for a K that was not
+// built. isa forces "scalar" or "avx2"; NULL picks the best one the CPU
+// supports.
+Autolykos2Pipeline autolykos2_select_pipeline(uint32_t table_size, uint32_t k, uint32_t lanes,
+                                              const char* isa = nullptr);
+
+// True if isa names a pipeline build this CPU can run
+bool autolykos2_pipeline_isa_supported(const char* isa);
+
+// Per-ISA lookups, one per instantiation translation unit. Each returns
+// NULL for combinations it was not built with.
+autolykos2_scan_fn autolykos2_pipeline_scalar(uint32_t table_bits, uint32_t k, uint32_t lanes);
+autolykos2_scan_fn autolykos2_pipeline_avx2(uint32_t table_bits, uint32_t k, uint32_t lanes);
+
+#endif // AUTOLYKOS2_CPU_PIPELINE_H
@@ -0,0 +1,15 @@
+// autolykos2_cpu_pipeline_avx2.cpp
+//
+// Built with -mavx2 (see Makefile). Only reached after a runtime CPU check.
+#include "autolykos2_cpu_pipeline_impl.h"
+
+autolykos2_scan_fn autolykos2_pipeline_avx2(uint32_t table_bits, uint32_t k, uint32_t lanes) {
+#ifdef __AVX2__
+    return lookup_scan(table_bits, k, lanes);
+#else
+    (void)table_bits;
+    (void)k;
+    (void)lanes;
+    return nullptr;
+#endif
+}
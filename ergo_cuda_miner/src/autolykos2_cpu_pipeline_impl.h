@@ -0,0 +1,311 @@
+// autolykos2_cpu_pipeline_impl.h
+//
+// Scan templates. Included only by the per-ISA instantiation units, each of
+// which is compiled with its own target flags.
+#ifndef AUTOLYKOS2_CPU_PIPELINE_IMPL_H
+#define AUTOLYKOS2_CPU_PIPELINE_IMPL_H
+
+#include "autolykos2_cpu_miner.h"
+#include "autolykos2_cpu_pipeline.h"
+#include "autolykos2_cpu_stages.h"
+
+namespace {
+
+inline uint64_t rotr64(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+// Blake2b rounds for Lanes independent states in structure-of-arrays
+// layout: v[i][l] is word i of lane l, so every step of G is one loop
+// across lanes that the compiler maps onto vector registers. Inlined and
+// unrolled so the sigma indices are constants; with runtime message
+// indices the lane loops stay scalar.
+template <uint32_t Lanes>
+__attribute__((always_inline)) inline void b2b_mix_lanes(uint64_t (&v)[16][Lanes], const uint64_t (&m)[16][Lanes]) {
+    #pragma GCC unroll 12
+    for (int r = 0; r < 12; ++r) {
+        const uint8_t* s = sigma[r];
+        #define GL(a,b,c,d,x,y) \
+            for (uint32_t l = 0; l < Lanes; ++l) { \
+                v[a][l] = v[a][l] + v[b][l] + m[s[x]][l]; \
+                v[d][l] = rotr64(v[d][l] ^ v[a][l], 32); \
+                v[c][l] = v[c][l] + v[d][l]; \
+                v[b][l] = rotr64(v[b][l] ^ v[c][l], 24); \
+                v[a][l] = v[a][l] + v[b][l] + m[s[y]][l]; \
+                v[d][l] = rotr64(v[d][l] ^ v[a][l], 16); \
+                v[c][l] = v[c][l] + v[d][l]; \
+                v[b][l] = rotr64(v[b][l] ^ v[c][l], 63); \
+            }
+        GL(0,4,8,12,0,1);
+        GL(1,5,9,13,2,3);
+        GL(2,6,10,14,4,5);
+        GL(3,7,11,15,6,7);
+        GL(0,5,10,15,8,9);
+        GL(1,6,11,12,10,11);
+        GL(2,7,8,13,12,13);
+        GL(3,4,9,14,14,15);
+        #undef GL
+    }
+}
+
+// Single-block unkeyed Blake2b-256 of a bytes-long message for every lane.
+// Writes the four digest words, little-endian.
+template <uint32_t Lanes>
+inline void b2b_final_lanes(const uint64_t (&m)[16][Lanes], uint64_t bytes, uint64_t (&out)[4][Lanes]) {
+    uint64_t v[16][Lanes];
+    for (int i = 0; i < 8; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) {
+            v[i][l] = ivals[i];
+            v[8 + i][l] = ivals[i];
+        }
+    for (uint32_t l = 0; l < Lanes; ++l) {
+        v[8][l] = 0x6A09E667F3BCC908ULL;  // ivals[0] carries the parameter block; v[8] takes the raw IV
+        v[12][l] ^= bytes;
+        v[14][l] = ~v[14][l];
+    }
+    b2b_mix_lanes<Lanes>(v, m);
+    for (int i = 0; i < 4; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) out[i][l] = ivals[i] ^ v[i][l] ^ v[8 + i][l];
+}
+
+// The header as Blake2b message words: words 0-8 whole, and the low half
+// of word 9 (the nonce fills its high half and word 10)
+struct HeaderWords {
+    uint64_t w[10];
+
+    explicit HeaderWords(const uint8_t* header) {
+        memset(w, 0, sizeof(w));
+        memcpy(w, header, AUTOLYKOS2_HEADER_SIZE);
+    }
+};
+
+// Lanes consecutive nonces through every stage in structure-of-arrays
+// layout: both Blake2b passes and the seed mix, index extraction, the
+// element sum, and the target compare. The compare looks at the top word
+// of every lane first and leaves the group at once when no lane can be
+// below the target, which is nearly always.
+template <uint32_t K, uint32_t Lanes, typename Index>
+inline void hash_lanes_soa(
+    const uint32_t* dataset,
+    Index index,
+    const HeaderWords& hw,
+    uint64_t nonce,
+    const uint64_t bound[4],
+    std::atomic<bool>* found_flag,
+    uint64_t* found_nonce,
+    uint8_t* found_hash
+) {
+    // Stage 1: hash1 = Blake2b(header || nonce), then the seed mix
+    uint64_t m[16][Lanes];
+    uint64_t hash1[4][Lanes];
+    for (int i = 0; i < 9; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) m[i][l] = hw.w[i];
+    for (uint32_t l = 0; l < Lanes; ++l) {
+        uint64_t n = nonce + l;
+        m[9][l] = hw.w[9] | (n << 32);
+        m[10][l] = n >> 32;
+    }
+    for (int i = 11; i < 16; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) m[i][l] = 0;
+    b2b_final_lanes<Lanes>(m, AUTOLYKOS2_HEADER_SIZE + 8, hash1);
+
+    uint64_t v[16][Lanes];
+    for (int i = 0; i < 8; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) {
+            v[i][l] = ivals[i];
+            v[8 + i][l] = ivals[i];
+        }
+    for (uint32_t l = 0; l < Lanes; ++l) {
+        v[12][l] ^= 40;
+        v[14][l] = ~v[14][l];
+    }
+    for (int i = 0; i < 4; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) m[i][l] = hash1[i][l];
+    for (uint32_t l = 0; l < Lanes; ++l) m[4][l] = __builtin_bswap64(nonce + l);
+    for (int i = 5; i < 16; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) m[i][l] = 0;
+    b2b_mix_lanes<Lanes>(v, m);
+
+    uint32_t r[NUM_SIZE_32][Lanes];
+    for (int j = 0; j < NUM_SIZE_32 / 2; ++j)
+        for (uint32_t l = 0; l < Lanes; ++l) {
+            uint64_t hsh = ivals[j] ^ v[j][l] ^ v[8 + j][l];
+            r[2 * j][l] = (uint32_t)hsh;
+            r[2 * j + 1][l] = (uint32_t)(hsh >> 32);
+        }
+
+    // Stage 2: indices, index k of every lane side by side
+    uint32_t ind[K][Lanes];
+    for (uint32_t k = 0; k < K; ++k)
+        for (uint32_t l = 0; l < Lanes; ++l)
+            ind[k][l] = index(rotl32(r[(k / 4) % NUM_SIZE_32][l], 8 * (k % 4)));
+    for (uint32_t k = 0; k < K; ++k)
+        for (uint32_t l = 0; l < Lanes; ++l)
+            __builtin_prefetch(&dataset[ind[k][l]], 0, 0);
+
+    // Stage 3: elements are 32 bits and only the low 64 bits of the sum
+    // are hashed, so a 64-bit accumulator per lane never carries
+    uint64_t sum[Lanes];
+    for (uint32_t l = 0; l < Lanes; ++l) sum[l] = 0;
+    for (uint32_t k = 0; k < K; ++k)
+        for (uint32_t l = 0; l < Lanes; ++l) sum[l] += dataset[ind[k][l]];
+
+    // Stage 4: Blake2b(hash1 || sum)
+    for (int i = 0; i < 4; ++i)
+        for (uint32_t l = 0; l < Lanes; ++l) m[i][l] = hash1[i][l];
+    for (uint32_t l = 0; l < Lanes; ++l) m[4][l] = sum[l];
+    uint64_t hash[4][Lanes];
+    b2b_final_lanes<Lanes>(m, 40, hash);
+
+    bool any = false;
+    for (uint32_t l = 0; l < Lanes; ++l) any |= hash[3][l] <= bound[3];
+    if (!any) return;
+
+    for (uint32_t l = 0; l < Lanes; ++l) {
+        uint64_t h[4] = {hash[0][l], hash[1][l], hash[2][l], hash[3][l]};
+        if (!meets_target((const uint8_t*)h, (const uint8_t*)bound)) continue;
+        bool expected = false;
+        if (found_flag->compare_exchange_strong(expected, true)) {
+            *found_nonce = nonce + l;
+            memcpy(found_hash, h, 32);
+        }
+    }
+}
+
+// Hashes Lanes consecutive nonces. The seed and index stages run for the
+// whole group first so every dataset read can be prefetched before the
+// first one is consumed.
+template <uint32_t K, uint32_t Lanes, typename Index>
+inline void hash_lanes(
+    const uint32_t* dataset,
+    Index index,
+    const uint8_t* header,
+    uint64_t nonce,
+    const uint8_t* target_boundary,
+    std::atomic<bool>* found_flag,
+    uint64_t* found_nonce,
+    uint8_t* found_hash
+) {
+    uint8_t hash1[Lanes][32];
+    uint32_t ind[Lanes][K];
+
+    for (uint32_t g = 0; g < Lanes; ++g) {
+        uint32_t r[NUM_SIZE_32];
+        seed_stage(header, nonce + g, hash1[g], r);
+        index_stage<K>(r, index, ind[g]);
+    }
+    for (uint32_t g = 0; g < Lanes; ++g)
+        for (uint32_t k = 0; k < K; ++k)
+            __builtin_prefetch(&dataset[ind[g][k]], 0, 0);
+    for (uint32_t g = 0; g < Lanes; ++g) {
+        uint64_t sum = 0;
+        for (uint32_t k = 0; k < K; ++k) sum += dataset[ind[g][k]];
+        uint8_t hash[32];
+        final_stage(hash1[g], sum, hash);
+        if (!meets_target(hash, target_boundary)) continue;
+        bool expected = false;
+        if (found_flag->compare_exchange_strong(expected, true)) {
+            *found_nonce = nonce + g;
+            memcpy(found_hash, hash, 32);
+        }
+    }
+}
+
+// Groups this deep run the structure-of-arrays pipeline. Below it there
+// is too little work per step to fill the vectors and the interleaved
+// scalar path is faster.
+constexpr uint32_t kSoaMinLanes = 16;
+
+template <uint32_t K, uint32_t Lanes, typename Index>
+void scan_range(
+    const uint32_t* dataset,
+    Index index,
+    const uint8_t* header,
+    uint64_t begin,
+    uint64_t end,
+    const uint8_t* target_boundary,
+    std::atomic<bool>* found_flag,
+    uint64_t* found_nonce,
+    uint8_t* found_hash
+) {
+    uint64_t nonce = begin;
+    if constexpr (Lanes >= kSoaMinLanes) {
+        const HeaderWords hw(header);
+        uint64_t bound[4];
+        memcpy(bound, target_boundary, 32);
+        for (; end - nonce >= Lanes; nonce += Lanes)
+            hash_lanes_soa<K, Lanes>(dataset, index, hw, nonce, bound, found_flag, found_nonce, found_hash);
+    } else {
+        for (; end - nonce >= Lanes; nonce += Lanes)
+            hash_lanes<K, Lanes>(dataset, index, header, nonce, target_boundary, found_flag, found_nonce, found_hash);
+    }
+    // end wraps to 0 for a range ending at the last nonce, so the tail
+    // compares for equality
+    for (; nonce != end; ++nonce)
+        hash_lanes<K, 1>(dataset, index, header, nonce, target_boundary, found_flag, found_nonce, found_hash);
+}
+
+// NBits != 0 masks to a compile-time 2^NBits table and table_size is
+// ignored. NBits == 0 indexes modulo the runtime table_size.
+template <uint32_t NBits, uint32_t K, uint32_t Lanes>
+void scan(
+    const uint32_t* dataset,
+    uint32_t table_size,
+    const uint8_t* header,
+    uint64_t begin,
+    uint64_t end,
+    const uint8_t* target_boundary,
+    std::atomic<bool>* found_flag,
+    uint64_t* found_nonce,
+    uint8_t* found_hash
+) {
+    if constexpr (NBits != 0) {
+        constexpr MaskIndex index{(uint32_t)((1ull << NBits) - 1)};
+        scan_range<K, Lanes>(dataset, index, header, begin, end, target_boundary, found_flag, found_nonce, found_hash);
+    } else if ((table_size & (table_size - 1)) == 0) {
+        scan_range<K, Lanes>(dataset, MaskIndex{table_size - 1}, header, begin, end, target_boundary,
+                             found_flag, found_nonce, found_hash);
+    } else {
+        scan_range<K, Lanes>(dataset, ModIndex(table_size), header, begin, end, target_boundary,
+                             found_flag, found_nonce, found_hash);
+    }
+}
+
+template <uint32_t NBits, uint32_t K>
+autolykos2_scan_fn scan_for_lanes(uint32_t lanes) {
+    switch (lanes) {
+    case 1:  return scan<NBits, K, 1>;
+    case 2:  return scan<NBits, K, 2>;
+    case 4:  return scan<NBits, K, 4>;
+    case 8:  return scan<NBits, K, 8>;
+    case 16: return scan<NBits, K, 16>;
+    case 32: return scan<NBits, K, 32>;
+    default: return nullptr;
+    }
+}
+
+static_assert(AUTOLYKOS2_CPU_MAX_INTERLEAVE == 32, "scan_for_lanes must cover every lane count");
+
+template <uint32_t K>
+autolykos2_scan_fn scan_for_table(uint32_t table_bits, uint32_t lanes) {
+    switch (table_bits) {
+    case AUTOLYKOS2_N:     return scan_for_lanes<AUTOLYKOS2_N, K>(lanes);
+    case AUTOLYKOS2_N + 1: return scan_for_lanes<AUTOLYKOS2_N + 1, K>(lanes);
+    case 0:                return scan_for_lanes<0, K>(lanes);
+    default:               return nullptr;
+    }
+}
+
+// Specialized table sizes: the mainnet table and the next doubling, with
+// everything else served by the runtime-size scan. K is fixed by the
+// protocol, so K_LEN is the only index count built.
+inline autolykos2_scan_fn lookup_scan(uint32_t table_bits, uint32_t k, uint32_t lanes) {
+    switch (k) {
+    case K_LEN: return scan_for_table<K_LEN>(table_bits, lanes);
+    default:    return nullptr;
+    }
+}
+
+} // namespace
+
+#endif // AUTOLYKOS2_CPU_PIPELINE_IMPL_H
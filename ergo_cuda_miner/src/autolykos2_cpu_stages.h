@@ -0,0 +1,197 @@
+// autolykos2_cpu_stages.h
+//
+// Per-nonce hashing stages shared by the CPU reference hash and the
+// specialized CPU pipelines. Everything here has internal linkage: the
+// header is compiled into translation units built for different ISAs, and
+// those copies must never be merged by the linker.
+#ifndef AUTOLYKOS2_CPU_STAGES_H
+#define AUTOLYKOS2_CPU_STAGES_H
+
+#include "autolykos2_params.h"
+#include "blake2b.h"
+#include <stdint.h>
+#include <string.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Same IV as the CUDA kernel: IV[0] already carries the 32-byte digest parameter
+const uint64_t ivals[8] = {
+    0x6A09E667F2BDC928ULL, 0xBB67AE8584CAA73BULL,
+    0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL,
+    0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+const uint8_t sigma[12][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15 },
+    {14,10, 4, 8, 9,15,13, 6, 1,12, 0, 2,11, 7, 5, 3 },
+    {11, 8,12, 0, 5, 2,15,13,10,14, 3, 6, 7, 1, 9, 4 },
+    { 7, 9, 3, 1,13,12,11,14, 2, 6, 5,10, 4, 0,15, 8 },
+    { 9, 0, 5, 7, 2, 4,10,15,14, 1,11,12, 6, 8, 3,13 },
+    { 2,12, 6,10, 0,11, 8, 3, 4,13, 7, 5,15,14, 1, 9 },
+    {12, 5, 1,15,14,13, 4,10, 0, 7, 6, 3, 9, 2, 8,11 },
+    {13,11, 7,14,12, 1, 3, 9, 5, 0,15, 4, 8, 6, 2,10 },
+    { 6,15,14, 9,11, 3, 0, 8,12, 2,13, 7, 1, 4,10, 5 },
+    {10, 2, 8, 4, 7, 6, 1, 5,15,11, 9,14, 3,12,13, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15 },
+    {14,10, 4, 8, 9,15,13, 6, 1,12, 0, 2,11, 7, 5, 3 }
+};
+
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+inline uint32_t rotl32(uint32_t x, int n) {
+    return n ? (x << n) | (x >> (32 - n)) : x;
+}
+
+inline void b2b_mix(uint64_t v[16], const uint64_t m[16]) {
+    for (int r = 0; r < 12; ++r) {
+        #define G(a,b,c,d,x,y) \
+            v[a] = v[a] + v[b] + m[sigma[r][x]]; \
+            v[d] = ROTR64(v[d] ^ v[a], 32); \
+            v[c] = v[c] + v[d]; \
+            v[b] = ROTR64(v[b] ^ v[c], 24); \
+            v[a] = v[a] + v[b] + m[sigma[r][y]]; \
+            v[d] = ROTR64(v[d] ^ v[a], 16); \
+            v[c] = v[c] + v[d]; \
+            v[b] = ROTR64(v[b] ^ v[c], 63);
+
+        G(0,4,8,12,0,1);
+        G(1,5,9,13,2,3);
+        G(2,6,10,14,4,5);
+        G(3,7,11,15,6,7);
+        G(0,5,10,15,8,9);
+        G(1,6,11,12,10,11);
+        G(2,7,8,13,12,13);
+        G(3,4,9,14,14,15);
+        #undef G
+    }
+}
+
+// Dataset element idx: the first four bytes, little-endian, of
+// Blake2b-256(seed || idx LE)
+inline uint32_t element_stage(const uint8_t* seed, uint32_t idx) {
+    uint8_t input[AUTOLYKOS2_SEED_SIZE + 4];
+    uint8_t hash[32];
+    memcpy(input, seed, AUTOLYKOS2_SEED_SIZE);
+    input[32] = idx & 0xFF;
+    input[33] = (idx >> 8) & 0xFF;
+    input[34] = (idx >> 16) & 0xFF;
+    input[35] = (idx >> 24) & 0xFF;
+    blake2b(hash, 32, input, sizeof(input), nullptr, 0);
+    return ((uint32_t)hash[0]) |
+           ((uint32_t)hash[1] << 8) |
+           ((uint32_t)hash[2] << 16) |
+           ((uint32_t)hash[3] << 24);
+}
+
+// Stage 1: first Blake2b over header || nonce, then the seed mix that yields r
+inline void seed_stage(const uint8_t* header, uint64_t nonce,
+                       uint8_t hash1[32], uint32_t r[NUM_SIZE_32]) {
+    uint8_t mining_input[AUTOLYKOS2_HEADER_SIZE + 8];
+    memcpy(mining_input, header, AUTOLYKOS2_HEADER_SIZE);
+    for (int i = 0; i < 8; ++i)
+        mining_input[AUTOLYKOS2_HEADER_SIZE + i] = (nonce >> (8 * i)) & 0xFF;
+    blake2b(hash1, 32, mining_input, sizeof(mining_input), nullptr, 0);
+
+    // Seed mix over hash1 and the byte-swapped nonce
+    uint64_t aux[32];
+    for (int i = 0; i < 8; ++i) {
+        aux[i] = ivals[i];
+        aux[8 + i] = ivals[i];
+    }
+    aux[12] ^= 40;
+    aux[14] = ~aux[14];
+    memcpy(aux + 16, hash1, 32);
+    aux[20] = __builtin_bswap64(nonce);
+    for (int i = 21; i < 32; ++i) aux[i] = 0;
+    b2b_mix(aux, aux + 16);
+
+    for (int j = 0; j < NUM_SIZE_32 / 2; ++j) {
+        uint64_t hsh = ivals[j] ^ aux[j] ^ aux[8 + j];
+        r[2 * j] = (uint32_t)hsh;
+        r[2 * j + 1] = (uint32_t)(hsh >> 32);
+    }
+}
+
+// Index words are reduced modulo the table size. Power-of-two tables mask;
+// other sizes use Lemire's multiply-shift reduction with m = ceil(2^64 / n),
+// exact for every 32-bit word.
+struct MaskIndex {
+    uint32_t mask;
+    uint32_t operator()(uint32_t x) const { return x & mask; }
+};
+
+struct ModIndex {
+    uint32_t n;
+    uint64_t m;
+    explicit ModIndex(uint32_t elements) : n(elements), m(UINT64_MAX / elements + 1) {}
+    uint32_t operator()(uint32_t x) const { return (uint32_t)(((unsigned __int128)(m * x) * n) >> 64); }
+};
+
+// Stage 2: the K dataset indices for one nonce. Index k is word
+// (k / 4) % 8 of r rotated left by 8 * (k % 4) bits, masked to the
+// power-of-two table size.
+template <uint32_t K>
+inline void index_stage(const uint32_t* r, uint32_t mask, uint32_t* ind) {
+#ifdef __AVX2__
+    if (K % 8 == 0) {
+        // Each 8-lane vector holds two r words broadcast four times, and
+        // one byte shuffle applies the 0/8/16/24-bit rotations.
+        const __m256i words = _mm256_loadu_si256((const __m256i*)r);
+        const __m256i vmask = _mm256_set1_epi32((int)mask);
+        const __m256i rot = _mm256_setr_epi8(
+            0, 1, 2, 3,  7, 4, 5, 6,  10, 11, 8, 9,  13, 14, 15, 12,
+            0, 1, 2, 3,  7, 4, 5, 6,  10, 11, 8, 9,  13, 14, 15, 12);
+        for (uint32_t v = 0; v < K / 8; ++v) {
+            const int w0 = (2 * v) % NUM_SIZE_32, w1 = (2 * v + 1) % NUM_SIZE_32;
+            __m256i sel = _mm256_setr_epi32(w0, w0, w0, w0, w1, w1, w1, w1);
+            __m256i out = _mm256_and_si256(
+                _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(words, sel), rot), vmask);
+            _mm256_storeu_si256((__m256i*)(ind + 8 * v), out);
+        }
+        return;
+    }
+#endif
+    for (uint32_t k = 0; k < K; ++k)
+        ind[k] = rotl32(r[(k / 4) % NUM_SIZE_32], 8 * (k % 4)) & mask;
+}
+
+template <uint32_t K>
+inline void index_stage(const uint32_t* r, MaskIndex index, uint32_t* ind) {
+    index_stage<K>(r, index.mask, ind);
+}
+
+// Same indices reduced modulo a table size that is not a power of two
+template <uint32_t K>
+inline void index_stage(const uint32_t* r, const ModIndex& index, uint32_t* ind) {
+    for (uint32_t k = 0; k < K; ++k)
+        ind[k] = index(rotl32(r[(k / 4) % NUM_SIZE_32], 8 * (k % 4)));
+}
+
+// Stage 4: final Blake2b over hash1 and the low 64 bits of the element sum
+inline void final_stage(const uint8_t hash1[32], uint64_t sum, uint8_t* out_hash) {
+    uint8_t final_input[40];
+    memcpy(final_input, hash1, 32);
+    for (int i = 0; i < 8; ++i) final_input[32 + i] = (sum >> (8 * i)) & 0xFF;
+    blake2b(out_hash, 32, final_input, sizeof(final_input), nullptr, 0);
+}
+
+inline bool meets_target(const uint8_t* hash, const uint8_t* target_boundary) {
+    uint64_t hash64[4], bound64[4];
+    memcpy(hash64, hash, 32);
+    memcpy(bound64, target_boundary, 32);
+    for (int i = 3; i >= 0; --i) {
+        if (hash64[i] < bound64[i]) return true;
+        if (hash64[i] > bound64[i]) return false;
+    }
+    return false;
+}
+
+#undef ROTR64
+
+} // namespace
+
+#endif // AUTOLYKOS2_CPU_STAGES_H
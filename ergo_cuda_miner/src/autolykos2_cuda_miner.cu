@@ -1,6 +1,7 @@
 // autolykos2_cuda_miner.cu
 
 #include "autolykos2_cuda_miner.h"
+#include "autolykos2_params.h"
 #include "blake2b_cuda.cuh"
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
@@ -13,14 +14,9 @@
 // Reference blake2b_sigma table defined in blake2b_cuda.cu
 extern __constant__ uint8_t blake2b_sigma[12][16];
 
-#define AUTOLYKOS2_N 26
-#define AUTOLYKOS2_K 32
-#define AUTOLYKOS2_M (1 << AUTOLYKOS2_N)
 #define BLOCK_SIZE 256
 #define GRID_SIZE 1024
 #define NONCES_PER_ITER (BLOCK_SIZE * GRID_SIZE)
-#define NUM_SIZE_32 8
-#define K_LEN 64
 
 #define B2B_IV(h) \
     do { \
@@ -79,8 +75,6 @@ const __constant__ uint64_t ivals[8] = {
     0x5BE0CD19137E2179
 };
 
-__constant__ uint8_t bound_[32];
-
 void decodeTarget(const std::string& targetStr, uint8_t* targetBytes) {
     mpz_t targetInt;
     mpz_init_set_str(targetInt, targetStr.c_str(), 10);
@@ -93,21 +87,15 @@ void decodeTarget(const std::string& targetStr, uint8_t* targetBytes) {
     mpz_clear(targetInt);
 }
 
-void cpyBSymbol(const uint8_t *bound) {
-    cudaError_t err = cudaMemcpyToSymbol(bound_, bound, 32);
-    if (err != cudaSuccess) {
-        fprintf(stderr, "CUDA error in cpyBSymbol: %s\n", cudaGetErrorString(err));
-    }
-}
-
 __global__ void autolykos2_mining_kernel(
     const uint32_t* dataset,
     const uint8_t* header,
+    const uint8_t* bound,
     uint64_t start_nonce,
-    uint32_t target_hi,
+    uint32_t nonce_count,
     uint64_t* d_found_nonce_param,
     uint8_t* d_found_hash_param,
-    bool* d_found_flag_param
+    int* d_found_flag_param
 ) {
     uint32_t tid = blockIdx.x * blockDim.x + threadIdx.x;
     uint64_t aux[32] = { 0 };
@@ -115,7 +103,7 @@ __global__ void autolykos2_mining_kernel(
     uint32_t r[NUM_SIZE_32 + 1] = { 0 };
     uint8_t j = 0;
 
-    if (tid < NONCES_PER_ITER) {
+    if (tid < nonce_count) {
         uint64_t nonce = start_nonce + tid;
         uint8_t mining_input[84];
 
@@ -156,23 +144,11 @@ __global__ void autolykos2_mining_kernel(
             ((uint32_t*)r)[j + 1] = ((uint32_t*)(&hsh))[1];
         }
 
-        uint32_t n_len = AUTOLYKOS2_M;
+        // Index k: word (k / 4) % 8 of r rotated left by 8 * (k % 4); table size is a power of two
+        #pragma unroll
         for (int k = 0; k < K_LEN; k++) {
-            uint32_t val;
-            int byte_idx = (k / 4) * 4;
-            if (byte_idx + 3 < 32)
-                val = ((uint32_t*)r)[byte_idx / 4];
-            else {
-                byte_idx = byte_idx % 32;
-                val = ((uint32_t*)r)[byte_idx / 4];
-            }
-            int sub_idx = k % 4;
-            uint32_t final_val;
-            if (sub_idx == 0) final_val = val;
-            else if (sub_idx == 1) final_val = (val << 8) | (val >> 24);
-            else if (sub_idx == 2) final_val = (val << 16) | (val >> 16);
-            else final_val = (val << 24) | (val >> 8);
-            ind[k] = final_val % n_len;
+            uint32_t val = r[(k / 4) % NUM_SIZE_32];
+            ind[k] = __funnelshift_l(val, val, 8 * (k % 4)) & (AUTOLYKOS2_M - 1);
         }
 
         uint32_t current_sum[NUM_SIZE_32 + 1] = {0};
@@ -200,16 +176,16 @@ __global__ void autolykos2_mining_kernel(
         uint8_t final_hash[32];
         blake2b_cuda(final_hash, final_input, 40);
 
-        // Compare final_hash with bound_ using 4x uint64_t little-endian words
+        // Compare final_hash with bound using 4x uint64_t little-endian words
         bool meets_target = false;
         uint64_t* hash64 = (uint64_t*)final_hash;
-        uint64_t* bound64 = (uint64_t*)bound_;
+        const uint64_t* bound64 = (const uint64_t*)bound;
         for (int i = 3; i >= 0; --i) {
             if (hash64[i] < bound64[i]) { meets_target = true; break; }
             if (hash64[i] > bound64[i]) { break; }
         }
         if (meets_target) {
-            if (atomicCAS((int*)d_found_flag_param, 0, 1) == 0) {
+            if (atomicCAS(d_found_flag_param, 0, 1) == 0) {
                 *d_found_nonce_param = nonce;
                 for (int i = 0; i < 32; ++i) d_found_hash_param[i] = final_hash[i];
             }
@@ -236,14 +212,16 @@ __global__ void generate_dataset_kernel(uint32_t* dataset, const uint8_t* seed,
         ((uint32_t)hash[3] << 24);
 }
 
-static uint32_t* d_dataset = nullptr;
-static uint8_t* d_header = nullptr;
-static uint64_t* d_found_nonce = nullptr;
-static uint8_t* d_found_hash = nullptr;
-static bool* d_found_flag = nullptr;
-static uint8_t* d_target_boundary = nullptr;
-static uint32_t* h_dataset = nullptr;
-static bool miner_initialized = false;
+struct autolykos2_cuda_ctx {
+    int device_id;
+    cudaStream_t stream;
+    uint32_t* d_dataset;
+    uint8_t* d_header;
+    uint8_t* d_bound;
+    uint64_t* d_found_nonce;
+    uint8_t* d_found_hash;
+    int* d_found_flag;
+};
 
 #define CUDA_CHECK_INIT(call) \
     do { \
@@ -254,113 +232,153 @@ static bool miner_initialized = false;
         } \
     } while(0)
 
-bool autolykos2_cuda_init(int device_id) {
-    if (miner_initialized) return true;
-    CUDA_CHECK_INIT(cudaSetDevice(device_id));
+static bool cuda_ctx_alloc(autolykos2_cuda_ctx* ctx) {
+    CUDA_CHECK_INIT(cudaSetDevice(ctx->device_id));
+    CUDA_CHECK_INIT(cudaStreamCreateWithFlags(&ctx->stream, cudaStreamNonBlocking));
     size_t dataset_size = AUTOLYKOS2_M * sizeof(uint32_t);
-    CUDA_CHECK_INIT(cudaMalloc(&d_dataset, dataset_size));
-    CUDA_CHECK_INIT(cudaMalloc(&d_header, 76));
-    CUDA_CHECK_INIT(cudaMalloc(&d_found_nonce, sizeof(uint64_t)));
-    CUDA_CHECK_INIT(cudaMalloc(&d_found_hash, 32));
-    CUDA_CHECK_INIT(cudaMalloc(&d_found_flag, sizeof(bool)));
-    CUDA_CHECK_INIT(cudaMalloc(&d_target_boundary, 32));
-    h_dataset = (uint32_t*)malloc(dataset_size);
-    if (!h_dataset) {
-        fprintf(stderr, "Failed to allocate host dataset memory\n");
-        return false;
-    }
-    miner_initialized = true;
+    CUDA_CHECK_INIT(cudaMalloc(&ctx->d_dataset, dataset_size));
+    CUDA_CHECK_INIT(cudaMalloc(&ctx->d_header, AUTOLYKOS2_HEADER_SIZE));
+    CUDA_CHECK_INIT(cudaMalloc(&ctx->d_bound, 32));
+    CUDA_CHECK_INIT(cudaMalloc(&ctx->d_found_nonce, sizeof(uint64_t)));
+    CUDA_CHECK_INIT(cudaMalloc(&ctx->d_found_hash, 32));
+    CUDA_CHECK_INIT(cudaMalloc(&ctx->d_found_flag, sizeof(int)));
     return true;
 }
 
-bool autolykos2_cuda_generate_dataset(const uint8_t* seed) {
-    if (!miner_initialized) {
+autolykos2_cuda_ctx* autolykos2_cuda_create(int device_id) {
+    autolykos2_cuda_ctx* ctx = new autolykos2_cuda_ctx{};
+    ctx->device_id = device_id;
+    if (!cuda_ctx_alloc(ctx)) {
+        autolykos2_cuda_destroy(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+bool autolykos2_cuda_ctx_generate_dataset(autolykos2_cuda_ctx* ctx, const uint8_t* seed) {
+    if (!ctx) {
         fprintf(stderr, "Miner not initialized\n");
         return false;
     }
+    CUDA_CHECK_INIT(cudaSetDevice(ctx->device_id));
     uint8_t* d_temp_seed = nullptr;
-    CUDA_CHECK_INIT(cudaMalloc(&d_temp_seed, 32));
-    CUDA_CHECK_INIT(cudaMemcpy(d_temp_seed, seed, 32, cudaMemcpyHostToDevice));
+    CUDA_CHECK_INIT(cudaMalloc(&d_temp_seed, AUTOLYKOS2_SEED_SIZE));
+    CUDA_CHECK_INIT(cudaMemcpyAsync(d_temp_seed, seed, AUTOLYKOS2_SEED_SIZE, cudaMemcpyHostToDevice, ctx->stream));
     const uint32_t chunk_size = 1024 * 1024;
     const uint32_t total_elements = AUTOLYKOS2_M;
     for (uint32_t start = 0; start < total_elements; start += chunk_size) {
         uint32_t count = (chunk_size < total_elements - start) ? chunk_size : (total_elements - start);
         dim3 block(BLOCK_SIZE);
         dim3 grid((count + BLOCK_SIZE - 1) / BLOCK_SIZE);
-        generate_dataset_kernel<<<grid, block>>>(d_dataset, d_temp_seed, start, count);
+        generate_dataset_kernel<<<grid, block, 0, ctx->stream>>>(ctx->d_dataset, d_temp_seed, start, count);
         CUDA_CHECK_INIT(cudaGetLastError());
-        CUDA_CHECK_INIT(cudaDeviceSynchronize());
+        CUDA_CHECK_INIT(cudaStreamSynchronize(ctx->stream));
         if (start % (chunk_size * 10) == 0) {
-            printf("Dataset generation: %.2f%%\n", 100.0f * (start + count) / total_elements);
+            printf("[GPU %d] Dataset generation: %.2f%%\n", ctx->device_id, 100.0f * (start + count) / total_elements);
         }
     }
     CUDA_CHECK_INIT(cudaFree(d_temp_seed));
-    printf("Dataset generation completed\n");
+    printf("[GPU %d] Dataset generation completed\n", ctx->device_id);
     return true;
 }
 
-bool autolykos2_cuda_mine(
+bool autolykos2_cuda_ctx_mine(
+    autolykos2_cuda_ctx* ctx,
     const uint8_t* header,
     uint64_t start_nonce,
     uint32_t nonce_count,
-    uint32_t target_hi,
     const uint8_t* target_boundary,
     uint64_t* found_nonce,
     uint8_t* found_hash,
     bool* found
 ) {
-    if (!miner_initialized) {
+    if (!ctx) {
         fprintf(stderr, "Miner not initialized\n");
         return false;
     }
-    CUDA_CHECK_INIT(cudaMemcpy(d_header, header, 76, cudaMemcpyHostToDevice));
-    cpyBSymbol(target_boundary);
+    CUDA_CHECK_INIT(cudaSetDevice(ctx->device_id));
+    CUDA_CHECK_INIT(cudaMemcpyAsync(ctx->d_header, header, AUTOLYKOS2_HEADER_SIZE, cudaMemcpyHostToDevice, ctx->stream));
+    CUDA_CHECK_INIT(cudaMemcpyAsync(ctx->d_bound, target_boundary, 32, cudaMemcpyHostToDevice, ctx->stream));
+    CUDA_CHECK_INIT(cudaMemsetAsync(ctx->d_found_flag, 0, sizeof(int), ctx->stream));
 
-    bool host_found = false;
-    CUDA_CHECK_INIT(cudaMemcpy(d_found_flag, &host_found, sizeof(bool), cudaMemcpyHostToDevice));
+    // nonce_count + BLOCK_SIZE - 1 would wrap for counts near 2^32
     dim3 block(BLOCK_SIZE);
-    dim3 grid((nonce_count + BLOCK_SIZE - 1) / BLOCK_SIZE);
-
-    autolykos2_mining_kernel<<<grid, block>>>(
-        d_dataset,
-        d_header,
+    dim3 grid(nonce_count / BLOCK_SIZE + (nonce_count % BLOCK_SIZE != 0));
+    autolykos2_mining_kernel<<<grid, block, 0, ctx->stream>>>(
+        ctx->d_dataset,
+        ctx->d_header,
+        ctx->d_bound,
         start_nonce,
-        target_hi,
-        d_found_nonce,
-        d_found_hash,
-        d_found_flag
+        nonce_count,
+        ctx->d_found_nonce,
+        ctx->d_found_hash,
+        ctx->d_found_flag
     );
     CUDA_CHECK_INIT(cudaGetLastError());
-    CUDA_CHECK_INIT(cudaDeviceSynchronize());
 
-    CUDA_CHECK_INIT(cudaMemcpy(&host_found, d_found_flag, sizeof(bool), cudaMemcpyDeviceToHost));
-    *found = host_found;
+    int host_found = 0;
+    CUDA_CHECK_INIT(cudaMemcpyAsync(&host_found, ctx->d_found_flag, sizeof(int), cudaMemcpyDeviceToHost, ctx->stream));
+    CUDA_CHECK_INIT(cudaStreamSynchronize(ctx->stream));
+    *found = host_found != 0;
 
     if (host_found) {
-        CUDA_CHECK_INIT(cudaMemcpy(found_nonce, d_found_nonce, sizeof(uint64_t), cudaMemcpyDeviceToHost));
-        CUDA_CHECK_INIT(cudaMemcpy(found_hash, d_found_hash, 32, cudaMemcpyDeviceToHost));
+        CUDA_CHECK_INIT(cudaMemcpy(found_nonce, ctx->d_found_nonce, sizeof(uint64_t), cudaMemcpyDeviceToHost));
+        CUDA_CHECK_INIT(cudaMemcpy(found_hash, ctx->d_found_hash, 32, cudaMemcpyDeviceToHost));
     }
     return true;
 }
 
+void autolykos2_cuda_destroy(autolykos2_cuda_ctx* ctx) {
+    if (!ctx) return;
+    cudaSetDevice(ctx->device_id);
+    if (ctx->d_dataset) cudaFree(ctx->d_dataset);
+    if (ctx->d_header) cudaFree(ctx->d_header);
+    if (ctx->d_bound) cudaFree(ctx->d_bound);
+    if (ctx->d_found_nonce) cudaFree(ctx->d_found_nonce);
+    if (ctx->d_found_hash) cudaFree(ctx->d_found_hash);
+    if (ctx->d_found_flag) cudaFree(ctx->d_found_flag);
+    if (ctx->stream) cudaStreamDestroy(ctx->stream);
+    delete ctx;
+}
+
+// ---------- Legacy single-device API ----------
+
+static autolykos2_cuda_ctx* g_default_ctx = nullptr;
+
+bool autolykos2_cuda_init(int device_id) {
+    if (g_default_ctx) return true;
+    g_default_ctx = autolykos2_cuda_create(device_id);
+    return g_default_ctx != nullptr;
+}
+
+bool autolykos2_cuda_generate_dataset(const uint8_t* seed) {
+    return autolykos2_cuda_ctx_generate_dataset(g_default_ctx, seed);
+}
+
+bool autolykos2_cuda_mine(
+    const uint8_t* header,
+    uint64_t start_nonce,
+    uint32_t nonce_count,
+    uint32_t target_hi,
+    const uint8_t* target_boundary,
+    uint64_t* found_nonce,
+    uint8_t* found_hash,
+    bool* found
+) {
+    (void)target_hi;
+    return autolykos2_cuda_ctx_mine(g_default_ctx, header, start_nonce, nonce_count,
+                                    target_boundary, found_nonce, found_hash, found);
+}
+
 void autolykos2_cuda_cleanup() {
-    if (!miner_initialized) return;
-    if (d_dataset) cudaFree(d_dataset);
-    if (d_header) cudaFree(d_header);
-    if (d_found_nonce) cudaFree(d_found_nonce);
-    if (d_found_hash) cudaFree(d_found_hash);
-    if (d_found_flag) cudaFree(d_found_flag);
-    if (d_target_boundary) cudaFree(d_target_boundary);
-    if (h_dataset) { free(h_dataset); h_dataset = nullptr; }
-    d_dataset = nullptr; d_header = nullptr; d_found_nonce = nullptr;
-    d_found_flag = nullptr; d_target_boundary = nullptr;
-    miner_initialized = false;
+    autolykos2_cuda_destroy(g_default_ctx);
+    g_default_ctx = nullptr;
 }
 
 uint64_t autolykos2_cuda_get_hashrate() {
     return GRID_SIZE * BLOCK_SIZE * 1000;
 }
-bool autolykos2_cuda_is_initialized() { return miner_initialized; }
+bool autolykos2_cuda_is_initialized() { return g_default_ctx != nullptr; }
 
 bool launchMiningKernel(
     const uint8_t* header,
@@ -370,17 +388,17 @@ bool launchMiningKernel(
     uint64_t& foundNonce,
     uint8_t* foundHash
 ) {
-    if (!miner_initialized) {
+    if (!g_default_ctx) {
         fprintf(stderr, "Miner not initialized\n");
         return false;
     }
     uint64_t found_nonce_64;
     bool found = false;
-    bool success = autolykos2_cuda_mine(
+    bool success = autolykos2_cuda_ctx_mine(
+        g_default_ctx,
         header,
         nonceStart,
         (uint32_t)nonceRange,
-        0,
         target,
         &found_nonce_64,
         foundHash,
@@ -8,6 +8,61 @@
 extern "C" {
 #endif
 
+/**
+ * Per-device CUDA miner state (dataset, header and result buffers).
+ * Contexts are independent, so several can mine concurrently.
+ */
+typedef struct autolykos2_cuda_ctx autolykos2_cuda_ctx;
+
+/**
+ * Create a CUDA miner context on a device
+ * @param device_id CUDA device ID to use
+ * @return new context, or NULL on failure
+ */
+autolykos2_cuda_ctx* autolykos2_cuda_create(int device_id);
+
+/**
+ * Generate the Autolykos2 dataset on the context's device
+ * @param ctx CUDA miner context
+ * @param seed 32-byte seed for dataset generation
+ * @return true on success, false on failure
+ */
+bool autolykos2_cuda_ctx_generate_dataset(autolykos2_cuda_ctx* ctx, const uint8_t* seed);
+
+/**
+ * Mine a nonce range on the context's device
+ * @param ctx CUDA miner context
+ * @param header 76-byte block header
+ * @param start_nonce Starting nonce value
+ * @param nonce_count Number of nonces to test
+ * @param target_boundary 32-byte little-endian target boundary
+ * @param found_nonce Output: found nonce if successful
+ * @param found_hash Output: hash of the found solution
+ * @param found Output: true if valid nonce found
+ * @return true on success, false on failure
+ */
+bool autolykos2_cuda_ctx_mine(
+    autolykos2_cuda_ctx* ctx,
+    const uint8_t* header,
+    uint64_t start_nonce,
+    uint32_t nonce_count,
+    const uint8_t* target_boundary,
+    uint64_t* found_nonce,
+    uint8_t* found_hash,
+    bool* found
+);
+
+/**
+ * Free all device resources owned by a context
+ * @param ctx CUDA miner context (may be NULL)
+ */
+void autolykos2_cuda_destroy(autolykos2_cuda_ctx* ctx);
+
+/*
+ * Legacy single-device API. These operate on a process-wide default
+ * context and are kept for existing callers.
+ */
+
 /**
  * Initialize the Autolykos2 CUDA miner
  * @param device_id CUDA device ID to use
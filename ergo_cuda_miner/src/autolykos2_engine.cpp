@@ -0,0 +1,178 @@
+// autolykos2_engine.cpp
+
+#include "autolykos2_engine.h"
+#include "autolykos2_cpu_miner.h"
+#include "autolykos2_params.h"
+#include "autolykos2_verifier.h"
+#include "dag_generator.h"
+#ifndef CORTEX_NO_CUDA
+#include "autolykos2_cuda_miner.h"
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+struct autolykos2_engine {
+    autolykos2_engine_kind kind;
+    std::string name;
+    uint32_t table_bits;
+    uint32_t table_size;            // Elements indexed for the current job, 0 = whole dataset
+    uint8_t seed[AUTOLYKOS2_SEED_SIZE];
+    bool has_dataset;
+    autolykos2_verifier* verifier;  // Table-less reference for autolykos2_engine_verify
+    autolykos2_cpu_ctx* cpu;
+#ifndef CORTEX_NO_CUDA
+    autolykos2_cuda_ctx* cuda;
+#endif
+};
+
+autolykos2_engine* autolykos2_engine_create(const autolykos2_engine_config* config) {
+    autolykos2_engine* engine = new autolykos2_engine{};
+    engine->kind = config->kind;
+    engine->table_bits = config->table_bits ? config->table_bits : AUTOLYKOS2_N;
+
+    switch (config->kind) {
+    case AUTOLYKOS2_ENGINE_CPU:
+        engine->name = "cpu";
+        engine->cpu = autolykos2_cpu_create(config->threads, config->table_bits);
+        if (engine->cpu) {
+            autolykos2_cpu_set_interleave(engine->cpu, config->interleave);
+            return engine;
+        }
+        break;
+    case AUTOLYKOS2_ENGINE_CUDA:
+#ifndef CORTEX_NO_CUDA
+        if (config->table_bits != 0 && config->table_bits != AUTOLYKOS2_N) {
+            fprintf(stderr, "CUDA engine only supports 2^%d dataset\n", AUTOLYKOS2_N);
+            break;
+        }
+        engine->name = "cuda:" + std::to_string(config->device_id);
+        engine->cuda = autolykos2_cuda_create(config->device_id);
+        if (engine->cuda) return engine;
+#else
+        fprintf(stderr, "CUDA engine requested but miner was built without CUDA\n");
+#endif
+        break;
+    default:
+        fprintf(stderr, "Unknown engine kind: %d\n", (int)config->kind);
+        break;
+    }
+    delete engine;
+    return nullptr;
+}
+
+bool autolykos2_engine_generate_dataset(autolykos2_engine* engine, const uint8_t* seed) {
+    if (!engine) return false;
+    bool ok = false;
+#ifndef CORTEX_NO_CUDA
+    if (engine->cuda) ok = autolykos2_cuda_ctx_generate_dataset(engine->cuda, seed);
+#endif
+    if (engine->cpu) ok = autolykos2_cpu_generate_dataset(engine->cpu, seed);
+    // Kept for autolykos2_engine_verify
+    if (ok) {
+        memcpy(engine->seed, seed, AUTOLYKOS2_SEED_SIZE);
+        autolykos2_verifier_destroy(engine->verifier);
+        engine->verifier = autolykos2_verifier_create(seed, engine->table_bits, AUTOLYKOS2_VERIFIER_DEFAULT_CACHE);
+        ok = engine->verifier != nullptr;
+        if (ok) autolykos2_verifier_set_table_size(engine->verifier, engine->table_size);
+    }
+    engine->has_dataset = ok;
+    return ok;
+}
+
+bool autolykos2_engine_mine(
+    autolykos2_engine* engine,
+    const uint8_t* header,
+    uint64_t start_nonce,
+    uint32_t nonce_count,
+    const uint8_t* target_boundary,
+    uint64_t* found_nonce,
+    uint8_t* found_hash,
+    bool* found
+) {
+    if (!engine) return false;
+#ifndef CORTEX_NO_CUDA
+    if (engine->cuda) {
+        return autolykos2_cuda_ctx_mine(engine->cuda, header, start_nonce, nonce_count,
+                                        target_boundary, found_nonce, found_hash, found);
+    }
+#endif
+    return autolykos2_cpu_mine(engine->cpu, header, start_nonce, nonce_count,
+                               target_boundary, found_nonce, found_hash, found);
+}
+
+uint32_t autolykos2_engine_set_height(autolykos2_engine* engine, uint32_t height) {
+    if (!engine) return 0;
+    uint64_t dataset = 1ull << engine->table_bits;
+    uint32_t size = (uint32_t)std::min<uint64_t>(autolykos2_table_size(height), dataset);
+    engine->table_size = size;
+    if (engine->cpu) autolykos2_cpu_set_table_size(engine->cpu, size);
+    if (engine->verifier) autolykos2_verifier_set_table_size(engine->verifier, size);
+    return size;
+}
+
+bool autolykos2_engine_verify(
+    const autolykos2_engine* engine,
+    const uint8_t* header,
+    uint64_t nonce,
+    const uint8_t* target_boundary,
+    uint8_t* out_hash
+) {
+    if (!engine || !engine->has_dataset) return false;
+    uint8_t hash[32];
+    autolykos2_verifier_hash(engine->verifier, header, nonce, hash);
+    if (out_hash) memcpy(out_hash, hash, 32);
+    return autolykos2_meets_target(hash, target_boundary);
+}
+
+bool autolykos2_engine_tune(autolykos2_engine* engine, const autolykos2_engine_tuning* tuning) {
+    if (!engine || !tuning) return false;
+    if (!engine->cpu) return true;
+    if (!autolykos2_cpu_set_isa(engine->cpu, tuning->isa)) {
+        fprintf(stderr, "Unsupported pipeline ISA: %s\n", tuning->isa);
+        return false;
+    }
+    autolykos2_cpu_set_interleave(engine->cpu, tuning->interleave);
+    int threads = tuning->threads ? tuning->threads : autolykos2_cpu_thread_count(engine->cpu);
+    autolykos2_cpu_set_active_threads(engine->cpu, threads);
+    return true;
+}
+
+int autolykos2_engine_set_active_threads(autolykos2_engine* engine, int threads) {
+    return engine ? autolykos2_cpu_set_active_threads(engine->cpu, threads) : 0;
+}
+
+int autolykos2_engine_thread_count(const autolykos2_engine* engine) {
+    return engine ? autolykos2_cpu_thread_count(engine->cpu) : 0;
+}
+
+bool autolykos2_engine_profile_stages(
+    const autolykos2_engine* engine,
+    const uint8_t* header,
+    uint32_t nonces,
+    autolykos2_stage_profile* out
+) {
+    if (!engine || !engine->cpu || !out) return false;
+    double ns[4];
+    if (!autolykos2_cpu_profile_stages(engine->cpu, header, nonces, ns)) return false;
+    out->seed_ns = ns[0];
+    out->index_ns = ns[1];
+    out->gather_ns = ns[2];
+    out->final_ns = ns[3];
+    return true;
+}
+
+const char* autolykos2_engine_name(const autolykos2_engine* engine) {
+    return engine ? engine->name.c_str() : "none";
+}
+
+void autolykos2_engine_destroy(autolykos2_engine* engine) {
+    if (!engine) return;
+    autolykos2_verifier_destroy(engine->verifier);
+    autolykos2_cpu_destroy(engine->cpu);
+#ifndef CORTEX_NO_CUDA
+    autolykos2_cuda_destroy(engine->cuda);
+#endif
+    delete engine;
+}
@@ -0,0 +1,173 @@
+#ifndef AUTOLYKOS2_ENGINE_H
+#define AUTOLYKOS2_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AUTOLYKOS2_ENGINE_CPU = 0,
+    AUTOLYKOS2_ENGINE_CUDA = 1
+} autolykos2_engine_kind;
+
+typedef struct {
+    autolykos2_engine_kind kind;
+    int device_id;        // CUDA device ID (CUDA engines)
+    int threads;          // Worker threads, 0 = all hardware threads (CPU engines)
+    uint32_t table_bits;  // log2 of the dataset size, 0 = AUTOLYKOS2_N
+    uint32_t interleave;  // Nonces gathered together per worker, 0 = default (CPU engines)
+} autolykos2_engine_config;
+
+// Runtime tuning knobs, applied with autolykos2_engine_tune
+typedef struct {
+    int threads;          // Active worker threads, 0 = all (CPU engines)
+    uint32_t interleave;  // Nonces gathered together per worker, 0 = default (CPU engines)
+    const char* isa;      // "scalar", "avx2", NULL = best available (CPU engines)
+} autolykos2_engine_tuning;
+
+// Mean time per nonce of each hashing stage, from autolykos2_engine_profile_stages
+typedef struct {
+    double seed_ns;    // Blake2b over header || nonce and the seed mix
+    double index_ns;   // Element index generation
+    double gather_ns;  // Dataset reads and the element sum
+    double final_ns;   // Final Blake2b
+} autolykos2_stage_profile;
+
+// Bumped whenever hashing code changes enough to invalidate tuned profiles
+#define AUTOLYKOS2_ENGINE_VERSION 1
+
+/**
+ * Opaque hashing engine handle. Each handle owns its own dataset and
+ * buffers, so any number of CPU and CUDA engines can run concurrently.
+ */
+typedef struct autolykos2_engine autolykos2_engine;
+
+/**
+ * Create a hashing engine
+ * @param config Backend selection and options
+ * @return new engine, or NULL on failure
+ */
+autolykos2_engine* autolykos2_engine_create(const autolykos2_engine_config* config);
+
+/**
+ * Generate the engine's Autolykos2 dataset
+ * @param engine Engine handle
+ * @param seed 32-byte seed for dataset generation
+ * @return true on success, false on failure
+ */
+bool autolykos2_engine_generate_dataset(autolykos2_engine* engine, const uint8_t* seed);
+
+/**
+ * Mine a nonce range
+ * @param engine Engine handle
+ * @param header 76-byte block header
+ * @param start_nonce Starting nonce value
+ * @param nonce_count Number of nonces to test
+ * @param target_boundary 32-byte little-endian target boundary
+ * @param found_nonce Output: found nonce if successful
+ * @param found_hash Output: hash of the found solution
+ * @param found Output: true if valid nonce found
+ * @return true on success, false on failure
+ */
+bool autolykos2_engine_mine(
+    autolykos2_engine* engine,
+    const uint8_t* header,
+    uint64_t start_nonce,
+    uint32_t nonce_count,
+    const uint8_t* target_boundary,
+    uint64_t* found_nonce,
+    uint8_t* found_hash,
+    bool* found
+);
+
+/**
+ * Set the block height of the job the following mine and verify calls hash
+ * for. The job indexes the network's table size at that height
+ * (autolykos2_table_size) when the dataset is larger, and the whole dataset
+ * otherwise; CPU engines switch to the pipeline specialized for that size.
+ * CUDA engines hold exactly 2^AUTOLYKOS2_N elements, which no height
+ * exceeds, and are unaffected.
+ * @param engine Engine handle
+ * @param height Job height
+ * @return table size in effect, 0 if engine is NULL
+ */
+uint32_t autolykos2_engine_set_height(autolykos2_engine* engine, uint32_t height);
+
+/**
+ * Recompute one nonce with the scalar CPU reference, independent of the
+ * engine's backend, using on-demand dataset elements from the seed passed
+ * to autolykos2_engine_generate_dataset (see autolykos2_verifier.h)
+ * @param engine Engine handle with a generated dataset
+ * @param header 76-byte block header
+ * @param nonce Nonce to verify
+ * @param target_boundary 32-byte little-endian target boundary
+ * @param out_hash Output: 32-byte reference hash (may be NULL)
+ * @return true if the reference hash meets the target
+ */
+bool autolykos2_engine_verify(
+    const autolykos2_engine* engine,
+    const uint8_t* header,
+    uint64_t nonce,
+    const uint8_t* target_boundary,
+    uint8_t* out_hash
+);
+
+/**
+ * Apply tuning knobs. Knobs the backend does not have are ignored.
+ * @param engine Engine handle
+ * @param tuning Settings to apply
+ * @return false if a knob value is invalid on this machine
+ */
+bool autolykos2_engine_tune(autolykos2_engine* engine, const autolykos2_engine_tuning* tuning);
+
+/**
+ * Limit how many worker threads hash (CPU engines)
+ * @param engine Engine handle
+ * @param threads Active threads, clamped to 1..autolykos2_engine_thread_count
+ * @return active threads after clamping, 0 if the engine has no thread control
+ */
+int autolykos2_engine_set_active_threads(autolykos2_engine* engine, int threads);
+
+/**
+ * Worker threads the engine was created with
+ * @param engine Engine handle
+ * @return thread count, 0 if the engine has no thread control
+ */
+int autolykos2_engine_thread_count(const autolykos2_engine* engine);
+
+/**
+ * Time each hashing stage in isolation on the calling thread (CPU engines)
+ * @param engine Engine handle with a generated dataset
+ * @param header 76-byte block header
+ * @param nonces Nonces to time
+ * @param out Output: mean ns per nonce of each stage
+ * @return false if the engine has no stage profile
+ */
+bool autolykos2_engine_profile_stages(
+    const autolykos2_engine* engine,
+    const uint8_t* header,
+    uint32_t nonces,
+    autolykos2_stage_profile* out
+);
+
+/**
+ * Human-readable engine name, e.g. "cpu" or "cuda:0"
+ * @param engine Engine handle
+ * @return NUL-terminated name owned by the engine
+ */
+const char* autolykos2_engine_name(const autolykos2_engine* engine);
+
+/**
+ * Destroy an engine and free its resources
+ * @param engine Engine handle (may be NULL)
+ */
+void autolykos2_engine_destroy(autolykos2_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // AUTOLYKOS2_ENGINE_H
@@ -0,0 +1,15 @@
+#ifndef AUTOLYKOS2_PARAMS_H
+#define AUTOLYKOS2_PARAMS_H
+
+// Shared Autolykos2 parameters used by every hashing backend
+
+#define AUTOLYKOS2_N 26
+#define AUTOLYKOS2_K 32
+#define AUTOLYKOS2_M (1 << AUTOLYKOS2_N)
+#define AUTOLYKOS2_HEADER_SIZE 76
+#define AUTOLYKOS2_HASH_SIZE 32
+#define AUTOLYKOS2_SEED_SIZE 32
+#define NUM_SIZE_32 8
+#define K_LEN 64
+
+#endif // AUTOLYKOS2_PARAMS_H
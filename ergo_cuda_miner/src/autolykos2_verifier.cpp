@@ -0,0 +1,177 @@
+// autolykos2_verifier.cpp
+
+#include "autolykos2_verifier.h"
+#include "autolykos2_cpu_stages.h"
+#include "autolykos2_params.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+static const uint32_t kNone = 0xFFFFFFFFu;
+
+// Fixed-capacity LRU of dataset elements. Slots form a doubly linked list
+// from most (head) to least (tail) recently used; the map finds an
+// element's slot.
+struct autolykos2_verifier {
+    uint8_t seed[AUTOLYKOS2_SEED_SIZE];
+    uint64_t dataset_size;  // 2^table_bits
+    uint32_t mask;          // Index mask when the table size is a power of two
+    ModIndex modulo{1};     // Index reduction otherwise, when use_modulo is set
+    bool use_modulo = false;
+    uint32_t capacity;
+    mutable std::mutex mtx;
+    std::unordered_map<uint32_t, uint32_t> slot_of;
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> values;
+    std::vector<uint32_t> prev;
+    std::vector<uint32_t> next;
+    uint32_t head = kNone;
+    uint32_t tail = kNone;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+static void unlink_slot(autolykos2_verifier* v, uint32_t s) {
+    if (v->prev[s] != kNone) v->next[v->prev[s]] = v->next[s];
+    else v->head = v->next[s];
+    if (v->next[s] != kNone) v->prev[v->next[s]] = v->prev[s];
+    else v->tail = v->prev[s];
+}
+
+static void push_front(autolykos2_verifier* v, uint32_t s) {
+    v->prev[s] = kNone;
+    v->next[s] = v->head;
+    if (v->head != kNone) v->prev[v->head] = s;
+    v->head = s;
+    if (v->tail == kNone) v->tail = s;
+}
+
+// Element idx from the cache, deriving and inserting it on a miss
+static uint32_t lookup(autolykos2_verifier* v, uint32_t idx) {
+    if (v->capacity == 0) {
+        v->misses++;
+        return element_stage(v->seed, idx);
+    }
+    auto it = v->slot_of.find(idx);
+    if (it != v->slot_of.end()) {
+        uint32_t s = it->second;
+        if (s != v->head) {
+            unlink_slot(v, s);
+            push_front(v, s);
+        }
+        v->hits++;
+        return v->values[s];
+    }
+
+    v->misses++;
+    uint32_t value = element_stage(v->seed, idx);
+    uint32_t s;
+    if (v->keys.size() < v->capacity) {
+        s = (uint32_t)v->keys.size();
+        v->keys.push_back(idx);
+        v->values.push_back(value);
+        v->prev.push_back(kNone);
+        v->next.push_back(kNone);
+    } else {
+        s = v->tail;
+        unlink_slot(v, s);
+        v->slot_of.erase(v->keys[s]);
+        v->keys[s] = idx;
+        v->values[s] = value;
+    }
+    v->slot_of.emplace(idx, s);
+    push_front(v, s);
+    return value;
+}
+
+static void hash_locked(autolykos2_verifier* v, const uint8_t* header, uint64_t nonce, uint8_t* out_hash) {
+    uint8_t hash1[32];
+    uint32_t r[NUM_SIZE_32];
+    uint32_t ind[K_LEN];
+    seed_stage(header, nonce, hash1, r);
+    if (v->use_modulo) index_stage<K_LEN>(r, v->modulo, ind);
+    else index_stage<K_LEN>(r, v->mask, ind);
+
+    uint64_t sum = 0;
+    for (int k = 0; k < K_LEN; ++k) sum += lookup(v, ind[k]);
+    final_stage(hash1, sum, out_hash);
+}
+
+autolykos2_verifier* autolykos2_verifier_create(const uint8_t* seed, uint32_t table_bits, uint32_t cache_elements) {
+    if (!seed) return nullptr;
+    if (table_bits == 0) table_bits = AUTOLYKOS2_N;
+    if (table_bits > 32) {
+        fprintf(stderr, "Verifier table_bits out of range: %u\n", table_bits);
+        return nullptr;
+    }
+    autolykos2_verifier* v = new autolykos2_verifier{};
+    memcpy(v->seed, seed, AUTOLYKOS2_SEED_SIZE);
+    v->dataset_size = 1ull << table_bits;
+    v->mask = (uint32_t)(v->dataset_size - 1);
+    v->capacity = cache_elements;
+    v->slot_of.reserve(cache_elements);
+    v->keys.reserve(cache_elements);
+    v->values.reserve(cache_elements);
+    v->prev.reserve(cache_elements);
+    v->next.reserve(cache_elements);
+    return v;
+}
+
+uint32_t autolykos2_verifier_set_table_size(autolykos2_verifier* verifier, uint32_t elements) {
+    if (!verifier) return 0;
+    std::lock_guard<std::mutex> lock(verifier->mtx);
+    uint64_t size = elements ? std::min<uint64_t>(elements, verifier->dataset_size) : verifier->dataset_size;
+    verifier->use_modulo = (size & (size - 1)) != 0;
+    if (verifier->use_modulo) verifier->modulo = ModIndex((uint32_t)size);
+    else verifier->mask = (uint32_t)(size - 1);
+    return (uint32_t)size;
+}
+
+bool autolykos2_verifier_hash(
+    autolykos2_verifier* verifier,
+    const uint8_t* header,
+    uint64_t nonce,
+    uint8_t* out_hash
+) {
+    if (!verifier) return false;
+    std::lock_guard<std::mutex> lock(verifier->mtx);
+    hash_locked(verifier, header, nonce, out_hash);
+    return true;
+}
+
+uint32_t autolykos2_verifier_verify_batch(
+    autolykos2_verifier* verifier,
+    const uint8_t* header,
+    const uint64_t* nonces,
+    uint32_t count,
+    const uint8_t* target_boundary,
+    uint8_t* out_hashes,
+    bool* valid
+) {
+    if (!verifier) return 0;
+    std::lock_guard<std::mutex> lock(verifier->mtx);
+    uint32_t passed = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint8_t hash[32];
+        hash_locked(verifier, header, nonces[i], hash);
+        bool ok = meets_target(hash, target_boundary);
+        if (out_hashes) memcpy(out_hashes + (size_t)i * 32, hash, 32);
+        if (valid) valid[i] = ok;
+        passed += ok;
+    }
+    return passed;
+}
+
+void autolykos2_verifier_stats(const autolykos2_verifier* verifier, uint64_t* hits, uint64_t* misses) {
+    if (!verifier) return;
+    std::lock_guard<std::mutex> lock(verifier->mtx);
+    if (hits) *hits = verifier->hits;
+    if (misses) *misses = verifier->misses;
+}
+
+void autolykos2_verifier_destroy(autolykos2_verifier* verifier) {
+    delete verifier;
+}
@@ -0,0 +1,98 @@
+#ifndef AUTOLYKOS2_VERIFIER_H
+#define AUTOLYKOS2_VERIFIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUTOLYKOS2_VERIFIER_DEFAULT_CACHE 4096
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Table-less hash verifier. Each nonce reads K_LEN dataset elements, and
+ * the verifier derives just those from the seed instead of holding the
+ * dataset, keeping recently used ones in a small LRU cache. Memory use is
+ * a few bytes per cached element, so shares can be checked on hosts that
+ * could never hold the table. Calls on one verifier are serialized;
+ * independent verifiers run concurrently.
+ */
+typedef struct autolykos2_verifier autolykos2_verifier;
+
+/**
+ * Create a verifier
+ * @param seed 32-byte dataset seed
+ * @param table_bits log2 of the dataset size (0 = AUTOLYKOS2_N)
+ * @param cache_elements Elements kept in the LRU cache (0 = no cache)
+ * @return new verifier, or NULL on failure
+ */
+autolykos2_verifier* autolykos2_verifier_create(const uint8_t* seed, uint32_t table_bits, uint32_t cache_elements);
+
+/**
+ * Index a smaller table than the dataset, as autolykos2_cpu_set_table_size
+ * does for the CPU engine
+ * @param verifier Verifier
+ * @param elements Table size (0 or anything above the dataset = the whole dataset)
+ * @return table size in effect (truncated to 32 bits for a 2^32 dataset), 0 if verifier is NULL
+ */
+uint32_t autolykos2_verifier_set_table_size(autolykos2_verifier* verifier, uint32_t elements);
+
+/**
+ * Hash one nonce, bit-identical to autolykos2_cpu_hash over the full dataset
+ * @param verifier Verifier
+ * @param header 76-byte block header
+ * @param nonce Nonce to hash
+ * @param out_hash Output: 32-byte final hash
+ * @return false if verifier is NULL
+ */
+bool autolykos2_verifier_hash(
+    autolykos2_verifier* verifier,
+    const uint8_t* header,
+    uint64_t nonce,
+    uint8_t* out_hash
+);
+
+/**
+ * Verify many nonces of one header in a single call. Element lookups of
+ * the whole batch share the cache, so repeated nonces and elements are
+ * derived once.
+ * @param verifier Verifier
+ * @param header 76-byte block header
+ * @param nonces Nonces to check
+ * @param count Number of nonces
+ * @param target_boundary 32-byte little-endian target boundary
+ * @param out_hashes Output: 32 bytes per nonce (may be NULL)
+ * @param valid Output: per nonce, true if its hash meets the target (may be NULL)
+ * @return number of nonces that meet the target
+ */
+uint32_t autolykos2_verifier_verify_batch(
+    autolykos2_verifier* verifier,
+    const uint8_t* header,
+    const uint64_t* nonces,
+    uint32_t count,
+    const uint8_t* target_boundary,
+    uint8_t* out_hashes,
+    bool* valid
+);
+
+/**
+ * Element cache counters since creation
+ * @param verifier Verifier
+ * @param hits Output: lookups served from the cache (may be NULL)
+ * @param misses Output: elements derived from the seed (may be NULL)
+ */
+void autolykos2_verifier_stats(const autolykos2_verifier* verifier, uint64_t* hits, uint64_t* misses);
+
+/**
+ * Free a verifier
+ * @param verifier Verifier (may be NULL)
+ */
+void autolykos2_verifier_destroy(autolykos2_verifier* verifier);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // AUTOLYKOS2_VERIFIER_H
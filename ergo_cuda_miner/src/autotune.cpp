@@ -0,0 +1,192 @@
+// autotune.cpp
+#include "autotune.h"
+#include "autolykos2_cpu_pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+using json = nlohmann::json;
+
+static std::string cpu_model() {
+    std::ifstream f("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.rfind("model name", 0) != 0) continue;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) break;
+        size_t start = line.find_first_not_of(' ', colon + 1);
+        return start == std::string::npos ? "unknown-cpu" : line.substr(start);
+    }
+    return "unknown-cpu";
+}
+
+std::string profile_key(const autolykos2_engine* engine, uint32_t table_bits) {
+    return cpu_model() + "|" + autolykos2_engine_name(engine) +
+           "|v" + std::to_string(AUTOLYKOS2_ENGINE_VERSION) +
+           "|2^" + std::to_string(table_bits);
+}
+
+static json read_cache(const std::string& path) {
+    std::ifstream f(path);
+    if (!f.is_open()) return json::object();
+    try {
+        json cache = json::parse(f);
+        return cache.is_object() ? cache : json::object();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "[AUTOTUNE] Ignoring unreadable profile cache %s: %s\n", path.c_str(), e.what());
+        return json::object();
+    }
+}
+
+bool load_profile(const std::string& path, const std::string& key, EngineProfile& profile) {
+    json cache = read_cache(path);
+    if (!cache.contains(key)) return false;
+    const json& p = cache[key];
+    profile.threads = p.value("threads", 0);
+    profile.interleave = p.value("interleave", 0u);
+    profile.isa = p.value("isa", "");
+    profile.batch_ms = p.value("batch_ms", 250u);
+    profile.hashrate = p.value("hashrate", 0.0);
+    return true;
+}
+
+bool save_profile(const std::string& path, const std::string& key, const EngineProfile& profile) {
+    json cache = read_cache(path);
+    cache[key] = {
+        {"threads", profile.threads},
+        {"interleave", profile.interleave},
+        {"isa", profile.isa},
+        {"batch_ms", profile.batch_ms},
+        {"hashrate", profile.hashrate},
+        {"tuned_at", (int64_t)time(nullptr)}
+    };
+    // Written aside and renamed over the cache, so a crash never leaves
+    // other hosts' profiles truncated
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        f << cache.dump(2) << "\n";
+        if (!f) {
+            fprintf(stderr, "[AUTOTUNE] Cannot write profile cache %s\n", tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "[AUTOTUNE] Cannot replace profile cache %s\n", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool apply_profile(autolykos2_engine* engine, const EngineProfile& profile) {
+    autolykos2_engine_tuning tuning{};
+    tuning.threads = profile.threads;
+    tuning.interleave = profile.interleave;
+    tuning.isa = profile.isa.empty() ? nullptr : profile.isa.c_str();
+    return autolykos2_engine_tune(engine, &tuning);
+}
+
+// Hashes back-to-back batches of nonces_per_call for at least seconds and
+// returns H/s. The all-zero target never hits, so only hashing is timed.
+static double measure(autolykos2_engine* engine, uint32_t nonces_per_call, double seconds) {
+    uint8_t header[76] = {0};
+    uint8_t target[32] = {0};
+    uint64_t nonce = 0, found_nonce;
+    uint8_t found_hash[32];
+    bool found;
+    uint64_t hashes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (elapsed < seconds) {
+        if (!autolykos2_engine_mine(engine, header, nonce, nonces_per_call, target,
+                                    &found_nonce, found_hash, &found)) {
+            return 0.0;
+        }
+        nonce += nonces_per_call;
+        hashes += nonces_per_call;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return hashes / elapsed;
+}
+
+static uint32_t nonces_for_ms(double rate, uint32_t ms) {
+    double n = rate * ms / 1000.0;
+    return (uint32_t)std::clamp(n, 256.0, (double)(1u << 30));
+}
+
+EngineProfile autotune_engine(autolykos2_engine* engine, double seconds_per_trial) {
+    EngineProfile best;
+    const int max_threads = autolykos2_engine_thread_count(engine);
+    const bool cpu = max_threads > 0;
+    if (seconds_per_trial <= 0.0) seconds_per_trial = 2.0;
+
+    // Rough rate for sizing trial batches to ~100 ms
+    double rate = measure(engine, 4096, 0.5);
+    auto trial = [&](const EngineProfile& p, const char* label) {
+        if (!apply_profile(engine, p)) return 0.0;
+        double r = measure(engine, nonces_for_ms(rate, 100), seconds_per_trial);
+        printf("[AUTOTUNE] %-28s %.2f H/s\n", label, r);
+        return r;
+    };
+
+    if (cpu) {
+        // 1. SIMD width x interleave depth with every thread
+        std::vector<std::string> isas = {"scalar"};
+        if (autolykos2_pipeline_isa_supported("avx2")) isas.push_back("avx2");
+        for (const auto& isa : isas) {
+            for (uint32_t depth = 1; depth <= 32; depth *= 2) {
+                EngineProfile p = best;
+                p.isa = isa;
+                p.interleave = depth;
+                char label[64];
+                snprintf(label, sizeof(label), "isa %s, interleave %u", isa.c_str(), depth);
+                double r = trial(p, label);
+                if (r > best.hashrate) { best = p; best.hashrate = r; }
+            }
+        }
+
+        // 2. Thread count: memory-bound hashing can saturate below all threads
+        std::vector<int> counts = {max_threads - 1, max_threads * 3 / 4, max_threads / 2, max_threads / 4};
+        counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+        EngineProfile base = best;
+        for (int n : counts) {
+            if (n < 1 || n >= max_threads) continue;
+            EngineProfile p = base;
+            p.threads = n;
+            char label[64];
+            snprintf(label, sizeof(label), "threads %d/%d", n, max_threads);
+            double r = trial(p, label);
+            if (r > best.hashrate) { best = p; best.hashrate = r; }
+        }
+    }
+    apply_profile(engine, best);
+    if (best.hashrate > 0.0) rate = best.hashrate;
+
+    // 3. Batch length: the shortest batch within 2% of the best rate, since
+    // shorter batches pick up job switches sooner
+    const uint32_t batch_candidates[] = {50, 100, 250, 500, 1000};
+    double rates[5];
+    double top = 0.0;
+    for (int i = 0; i < 5; ++i) {
+        rates[i] = measure(engine, nonces_for_ms(rate, batch_candidates[i]), seconds_per_trial);
+        printf("[AUTOTUNE] %-28s %.2f H/s\n", ("batch " + std::to_string(batch_candidates[i]) + " ms").c_str(), rates[i]);
+        top = std::max(top, rates[i]);
+    }
+    for (int i = 0; i < 5; ++i) {
+        if (rates[i] >= 0.98 * top) {
+            best.batch_ms = batch_candidates[i];
+            best.hashrate = rates[i];
+            break;
+        }
+    }
+
+    printf("[AUTOTUNE] Best: threads %d, interleave %u, isa %s, batch %u ms -> %.2f H/s\n",
+           best.threads ? best.threads : max_threads, best.interleave,
+           best.isa.empty() ? "auto" : best.isa.c_str(), best.batch_ms, best.hashrate);
+    return best;
+}
@@ -0,0 +1,33 @@
+// autotune.h
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "autolykos2_engine.h"
+#include <cstdint>
+#include <string>
+
+// Best known engine settings for one machine
+struct EngineProfile {
+    int threads = 0;          // Active worker threads, 0 = all
+    uint32_t interleave = 0;  // 0 = engine default
+    std::string isa;          // Empty = best available
+    uint32_t batch_ms = 250;  // Batch wall-time target for the mining thread
+    double hashrate = 0.0;    // H/s measured with these settings
+};
+
+// Cache key: CPU model, engine name, AUTOLYKOS2_ENGINE_VERSION and table size.
+// A profile is only reused on the hardware and code it was measured on.
+std::string profile_key(const autolykos2_engine* engine, uint32_t table_bits);
+
+// Profile cache: a JSON object mapping keys to profiles
+bool load_profile(const std::string& path, const std::string& key, EngineProfile& profile);
+bool save_profile(const std::string& path, const std::string& key, const EngineProfile& profile);
+
+bool apply_profile(autolykos2_engine* engine, const EngineProfile& profile);
+
+// Benchmarks the engine (dataset already generated) over ISA, interleave,
+// thread count and batch length, one dimension at a time, and returns the
+// fastest settings. Leaves the engine tuned to them.
+EngineProfile autotune_engine(autolykos2_engine* engine, double seconds_per_trial);
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,143 @@
+// bench.cpp
+#include "bench.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct SyntheticJob {
+    uint8_t header[76];
+};
+
+SyntheticJob make_job(std::mt19937_64& rng) {
+    SyntheticJob job;
+    for (size_t i = 0; i < sizeof(job.header); i += 8) {
+        uint64_t w = rng();
+        memcpy(job.header + i, &w, std::min<size_t>(8, sizeof(job.header) - i));
+    }
+    return job;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+std::string run_bench(autolykos2_engine* engine, const BenchConfig& config, const BenchContext& context) {
+    std::vector<uint8_t> target_be = difficulty_to_target_bytes(config.difficulty);
+    uint8_t target[32];
+    std::reverse_copy(target_be.begin(), target_be.end(), target);
+
+    std::mt19937_64 rng(config.seed);
+    SyntheticJob job = make_job(rng);
+    uint64_t jobs = 1, batches = 0, hashes = 0;
+    uint64_t shares = 0, invalid = 0;
+    double verify_s = 0.0, mine_s = 0.0;
+    uint32_t batch_size = 1u << 12;
+    uint64_t nonce = 0;
+    bool failed = false;
+    const uint64_t call_nonces = std::max<uint64_t>(256, (uint64_t)(config.difficulty / 16));
+
+    printf("[BENCH] %s, difficulty %g, %.0f s\n", autolykos2_engine_name(engine), config.difficulty, config.seconds);
+    auto t0 = std::chrono::steady_clock::now();
+    auto job_start = t0;
+    while (seconds_since(t0) < config.seconds) {
+        if (seconds_since(job_start) >= config.job_s) {
+            job = make_job(rng);
+            job_start = std::chrono::steady_clock::now();
+            nonce = 0;
+            jobs++;
+        }
+
+        // A hit stops the whole engine call, so parts of the range may go
+        // unscanned; the range either side of each hit is mined again until
+        // calls come back empty, which counts every share exactly once.
+        // Calls are kept well below the difficulty so rescans stay rare.
+        uint64_t end = nonce + batch_size;
+        auto b0 = std::chrono::steady_clock::now();
+        std::vector<std::pair<uint64_t, uint64_t>> pending{{nonce, end}};
+        while (!pending.empty() && !failed) {
+            auto [lo, hi] = pending.back();
+            pending.pop_back();
+            for (uint64_t start = lo; start < hi;) {
+                uint32_t count = (uint32_t)std::min<uint64_t>(hi - start, call_nonces);
+                uint64_t found_nonce;
+                uint8_t found_hash[32];
+                bool found = false;
+                if (!autolykos2_engine_mine(engine, job.header, start, count, target,
+                                            &found_nonce, found_hash, &found)) {
+                    failed = true;
+                    break;
+                }
+                if (found) {
+                    auto v0 = std::chrono::steady_clock::now();
+                    uint8_t ref[32];
+                    bool valid = autolykos2_engine_verify(engine, job.header, found_nonce, target, ref) &&
+                                 memcmp(ref, found_hash, 32) == 0;
+                    verify_s += seconds_since(v0);
+                    valid ? shares++ : invalid++;
+                    if (found_nonce > start) pending.emplace_back(start, found_nonce);
+                    if (found_nonce + 1 < start + count) pending.emplace_back(found_nonce + 1, start + count);
+                }
+                start += count;
+            }
+        }
+        nonce = end;
+        if (failed) break;
+        double batch_s = seconds_since(b0);
+        mine_s += batch_s;
+        hashes += batch_size;
+        batches++;
+
+        if (batch_s > 0.0) {
+            double want = batch_size / batch_s * config.batch_ms / 1000.0;
+            batch_size = (uint32_t)std::clamp(want, 256.0, (double)(1u << 30));
+            batch_size = (batch_size + 255) / 256 * 256;
+        }
+    }
+    double elapsed = seconds_since(t0);
+
+    json out = {
+        {"engine", autolykos2_engine_name(engine)},
+        {"engine_version", AUTOLYKOS2_ENGINE_VERSION},
+        {"compiler", __VERSION__},
+        {"threads", autolykos2_engine_thread_count(engine)},
+        {"table_bits", context.table_bits},
+        {"table_build_s", context.table_build_s},
+        {"profile", context.profile},
+        {"seconds", elapsed},
+        {"difficulty", config.difficulty},
+        {"jobs", jobs},
+        {"batches", batches},
+        {"hashes", hashes},
+        {"hashrate", elapsed > 0.0 ? hashes / elapsed : 0.0},
+        {"engine_busy", elapsed > 0.0 ? (mine_s - verify_s) / elapsed : 0.0},
+        {"shares", shares},
+        {"expected_shares", hashes / config.difficulty},
+        {"invalid_shares", invalid},
+        {"verify_ms_per_share", shares + invalid ? 1000.0 * verify_s / (shares + invalid) : 0.0},
+        {"failed", failed}
+    };
+
+    autolykos2_stage_profile stages;
+    if (config.profile_nonces &&
+        autolykos2_engine_profile_stages(engine, job.header, config.profile_nonces, &stages)) {
+        out["stage_ns"] = {
+            {"seed", stages.seed_ns},
+            {"index", stages.index_ns},
+            {"gather", stages.gather_ns},
+            {"final", stages.final_ns}
+        };
+    } else {
+        out["stage_ns"] = nullptr;
+    }
+    return out.dump();
+}
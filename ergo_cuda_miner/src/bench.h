@@ -0,0 +1,31 @@
+// bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "autolykos2_engine.h"
+#include <cstdint>
+#include <string>
+
+struct BenchConfig {
+    double seconds = 20.0;         // Timed hashing
+    double difficulty = 1e5;       // Share difficulty of the synthetic jobs
+    double job_s = 5.0;            // A new synthetic job this often
+    uint32_t batch_ms = 250;       // Batch wall-time target, as when mining
+    uint64_t seed = 1;             // Synthetic headers are drawn from this seed
+    uint32_t profile_nonces = 1u << 16;  // Nonces per stage in the stage split
+};
+
+// What the engine did before the timed run, recorded alongside the results
+struct BenchContext {
+    uint32_t table_bits = 0;
+    double table_build_s = 0.0;
+    std::string profile;           // Tuned profile key in use, empty if none
+};
+
+// Mines synthetic jobs on engine (dataset already generated) for
+// config.seconds and returns the results as one line of JSON: hashrate,
+// shares found against the number expected at this difficulty, stage split
+// and table build time.
+std::string run_bench(autolykos2_engine* engine, const BenchConfig& config, const BenchContext& context);
+
+#endif // BENCH_H
@@ -0,0 +1,115 @@
+// config_watcher.cpp
+#include "config_watcher.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// SIGHUP is turned into a byte on this pipe, the only async-signal-safe hand-off
+static int g_hup_pipe[2] = {-1, -1};
+
+static void on_sighup(int) {
+    int saved = errno;
+    if (g_hup_pipe[1] >= 0) {
+        char b = 1;
+        (void)!write(g_hup_pipe[1], &b, 1);
+    }
+    errno = saved;
+}
+
+static void drain(int fd) {
+    char buf[4096];
+    while (read(fd, buf, sizeof(buf)) > 0) {}
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& path, std::function<void()> on_change)
+    : on_change_(std::move(on_change))
+{
+    size_t slash = path.rfind('/');
+    dir_ = slash == std::string::npos ? "." : path.substr(0, slash);
+    name_ = slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start() {
+    if (thread_.joinable()) return true;
+    if (pipe2(stop_pipe_, O_CLOEXEC | O_NONBLOCK) < 0) return false;
+    if (g_hup_pipe[0] < 0 && pipe2(g_hup_pipe, O_CLOEXEC | O_NONBLOCK) < 0) return false;
+
+    struct sigaction sa{};
+    sa.sa_handler = on_sighup;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &sa, nullptr);
+
+    inotify_fd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd_ < 0 ||
+        inotify_add_watch(inotify_fd_, dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        std::cerr << "[CONFIG] inotify unavailable (" << strerror(errno) << "), reload on SIGHUP only" << std::endl;
+        if (inotify_fd_ >= 0) close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    thread_ = std::thread(&ConfigWatcher::run, this);
+    std::cout << "[CONFIG] Watching " << dir_ << "/" << name_ << " (send SIGHUP to force a reload)" << std::endl;
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (!thread_.joinable()) return;
+    char b = 1;
+    (void)!write(stop_pipe_[1], &b, 1);
+    thread_.join();
+    if (inotify_fd_ >= 0) close(inotify_fd_);
+    close(stop_pipe_[0]);
+    close(stop_pipe_[1]);
+    inotify_fd_ = -1;
+    stop_pipe_[0] = stop_pipe_[1] = -1;
+}
+
+void ConfigWatcher::run() {
+    for (;;) {
+        struct pollfd fds[3] = {
+            {stop_pipe_[0], POLLIN, 0},
+            {g_hup_pipe[0], POLLIN, 0},
+            {inotify_fd_, POLLIN, 0},
+        };
+        int nfds = inotify_fd_ >= 0 ? 3 : 2;
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[0].revents) return;
+
+        bool changed = false;
+        if (fds[1].revents & POLLIN) {
+            drain(g_hup_pipe[0]);
+            changed = true;
+        }
+        if (nfds == 3 && (fds[2].revents & POLLIN)) {
+            alignas(struct inotify_event) char buf[4096];
+            ssize_t n;
+            while ((n = read(inotify_fd_, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + n;) {
+                    auto* ev = reinterpret_cast<struct inotify_event*>(p);
+                    if (ev->len && name_ == ev->name) changed = true;
+                    p += sizeof(struct inotify_event) + ev->len;
+                }
+            }
+        }
+        if (!changed) continue;
+
+        // Let a multi-step save finish before reading the file
+        struct pollfd quiet = {stop_pipe_[0], POLLIN, 0};
+        if (poll(&quiet, 1, 200) > 0) return;
+        if (inotify_fd_ >= 0) drain(inotify_fd_);
+        drain(g_hup_pipe[0]);
+        on_change_();
+    }
+}
@@ -0,0 +1,33 @@
+// config_watcher.h
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <functional>
+#include <string>
+#include <thread>
+
+// Calls on_change from a background thread whenever the config file is
+// rewritten or the process receives SIGHUP. The file's directory is
+// watched with inotify, so editors that replace the file instead of
+// writing it in place are caught too. Bursts of events within 200 ms
+// collapse into one call.
+class ConfigWatcher {
+public:
+    ConfigWatcher(const std::string& path, std::function<void()> on_change);
+    ~ConfigWatcher();
+
+    bool start();
+    void stop();
+
+private:
+    void run();
+
+    std::string dir_;
+    std::string name_;
+    std::function<void()> on_change_;
+    int inotify_fd_ = -1;
+    int stop_pipe_[2] = {-1, -1};
+    std::thread thread_;
+};
+
+#endif // CONFIG_WATCHER_H
@@ -0,0 +1,85 @@
+// cpu_topology.cpp
+#include "cpu_topology.h"
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <thread>
+
+static std::string read_line(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty()) continue;
+        size_t dash = part.find('-');
+        int lo = atoi(part.c_str());
+        int hi = (dash == std::string::npos) ? lo : atoi(part.c_str() + dash + 1);
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// Drops the CPUs this process may not run on, as set by taskset or a
+// cpuset cgroup. Left unchanged if the affinity mask cannot be read.
+static void keep_allowed(std::vector<int>& cpus) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                              [&](int c) { return c < 0 || c >= CPU_SETSIZE || !CPU_ISSET(c, &allowed); }),
+               cpus.end());
+}
+
+std::vector<NumaNode> detect_numa_nodes() {
+    std::vector<NumaNode> nodes;
+    const char* base = "/sys/devices/system/node";
+    DIR* dir = opendir(base);
+    if (dir) {
+        while (struct dirent* ent = readdir(dir)) {
+            std::string name = ent->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4) continue;
+            if (name.find_first_not_of("0123456789", 4) != std::string::npos) continue;
+            NumaNode node;
+            node.id = atoi(name.c_str() + 4);
+            node.cpus = parse_cpulist(read_line(std::string(base) + "/" + name + "/cpulist"));
+            keep_allowed(node.cpus);
+            if (!node.cpus.empty()) nodes.push_back(node);
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+
+    if (nodes.empty()) {
+        NumaNode node;
+        node.id = 0;
+        node.cpus = parse_cpulist(read_line("/sys/devices/system/cpu/online"));
+        keep_allowed(node.cpus);
+        if (node.cpus.empty()) {
+            unsigned hw = std::thread::hardware_concurrency();
+            for (unsigned c = 0; c < (hw ? hw : 1); ++c) node.cpus.push_back((int)c);
+        }
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,25 @@
+// cpu_topology.h
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;  // Online logical CPUs local to this node
+};
+
+// Reads NUMA layout from /sys/devices/system/node, keeping only the CPUs in
+// the process affinity mask; nodes left without CPUs are dropped. Falls back
+// to a single node holding every allowed online CPU when sysfs has no node
+// information.
+std::vector<NumaNode> detect_numa_nodes();
+
+// Parses a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parse_cpulist(const std::string& list);
+
+// Restricts the calling thread to the given CPUs. Returns false on failure.
+bool pin_current_thread(const std::vector<int>& cpus);
+
+#endif // CPU_TOPOLOGY_H
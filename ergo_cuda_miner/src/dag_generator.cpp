@@ -1,25 +1,135 @@
 // dag_generator.cpp
 #include "dag_generator.h"
-#include "blake2b.h"
+#include "autolykos2_cpu_stages.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <vector>
-#include <array>
-#include <cstring>
-
-std::vector<std::array<uint8_t, 32>> generate_full_dag() {
-    std::vector<std::array<uint8_t, 32>> dag;
-    dag.reserve(256);
-
-    for (uint32_t i = 0; i < 256; ++i) {
-        std::array<uint8_t, 4> input{};
-        input[0] = i & 0xFF;
-        input[1] = (i >> 8) & 0xFF;
-        input[2] = (i >> 16) & 0xFF;
-        input[3] = (i >> 24) & 0xFF;
-
-        std::array<uint8_t, 32> output{};
-        blake2b(output.data(), 32, input.data(), input.size(), nullptr, 0);
-        dag.push_back(output);
+
+static const uint32_t kNBase = 1u << 26;
+static const uint32_t kIncreaseStart = 600 * 1024;
+static const uint32_t kIncreasePeriod = 50 * 1024;
+static const uint32_t kIncreaseHeightMax = 4198400;
+
+// The message is 8200 bytes: 64 full Blake2b blocks and an 8-byte tail
+static const int kFullBlocks = 64;
+static const uint64_t kMessageBytes = 4 + 4 + 1024 * 8;
+
+// Elements claimed per grab from the shared counter
+static const uint32_t kChunk = 1u << 14;
+
+uint32_t autolykos2_table_size(uint32_t height) {
+    height = std::min(height, kIncreaseHeightMax);
+    if (height < kIncreaseStart) return kNBase;
+    uint32_t iters = (height - kIncreaseStart) / kIncreasePeriod + 1;
+    uint32_t n = kNBase;
+    for (uint32_t i = 0; i < iters; ++i) n = n / 100 * 105;
+    return n;
+}
+
+namespace {
+
+// Message words of every block, decoded once. Past the first eight bytes
+// the message is M, whose 8-byte big-endian integers land on word
+// boundaries, so word w of block b is bswap(16b + w - 1). Only word 0 of
+// block 0 (index || height) differs between elements.
+struct MessageSchedule {
+    uint64_t words[kFullBlocks + 1][16];
+
+    MessageSchedule() {
+        for (int b = 0; b < kFullBlocks; ++b) {
+            for (int w = 0; w < 16; ++w) {
+                words[b][w] = __builtin_bswap64((uint64_t)(16 * b + w - 1));
+            }
+        }
+        memset(words[kFullBlocks], 0, sizeof(words[kFullBlocks]));
+        words[kFullBlocks][0] = __builtin_bswap64(1023);
+    }
+};
+
+const MessageSchedule& schedule() {
+    static const MessageSchedule s;
+    return s;
+}
+
+// Unkeyed Blake2b-256 of the element message, built in place
+void element_hash(const MessageSchedule& s, uint32_t height_be, uint32_t index, uint8_t out[32]) {
+    uint64_t h[8];
+    memcpy(h, ivals, sizeof(h));
+
+    uint64_t m0[16];
+    memcpy(m0, s.words[0], sizeof(m0));
+    m0[0] = (uint64_t)__builtin_bswap32(index) | ((uint64_t)height_be << 32);
+
+    for (int b = 0; b <= kFullBlocks; ++b) {
+        const uint64_t* m = b == 0 ? m0 : s.words[b];
+        const bool last = b == kFullBlocks;
+        uint64_t v[16];
+        memcpy(v, h, 8 * sizeof(uint64_t));
+        memcpy(v + 8, ivals, 8 * sizeof(uint64_t));
+        v[8] = 0x6A09E667F3BCC908ULL;  // ivals[0] carries the parameter block; v[8] takes the raw IV
+        v[12] ^= last ? kMessageBytes : 128ULL * (b + 1);
+        if (last) v[14] = ~v[14];
+        b2b_mix(v, m);
+        for (int i = 0; i < 8; ++i) h[i] ^= v[i] ^ v[i + 8];
+    }
+    memcpy(out, h, 32);
+}
+
+// Splits [0, count) over threads in dynamically claimed chunks; emit(index,
+// hash) stores one element. Progress is reported from the calling thread.
+template <typename Emit>
+bool build(uint32_t height, uint32_t count, const TableBuildOptions& options, Emit emit) {
+    const MessageSchedule& s = schedule();
+    const uint32_t height_be = __builtin_bswap32(height);
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, std::min<int>(threads, (count + kChunk - 1) / kChunk));
+
+    std::atomic<uint64_t> next{0};
+    std::atomic<uint64_t> done{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            uint8_t hash[32];
+            for (;;) {
+                uint64_t start = next.fetch_add(kChunk);
+                if (start >= count) break;
+                uint32_t end = (uint32_t)std::min<uint64_t>(start + kChunk, count);
+                for (uint32_t i = (uint32_t)start; i < end; ++i) {
+                    element_hash(s, height_be, i, hash);
+                    emit(i, hash);
+                }
+                done.fetch_add(end - start, std::memory_order_relaxed);
+            }
+        });
     }
 
-    return dag;
+    if (options.progress) {
+        const auto interval = std::chrono::milliseconds(options.progress_ms ? options.progress_ms : 250);
+        while (done.load(std::memory_order_relaxed) < count) {
+            std::this_thread::sleep_for(interval);
+            options.progress(done.load(std::memory_order_relaxed), count);
+        }
+    }
+    for (auto& t : pool) t.join();
+    return true;
+}
+
+} // namespace
+
+void autolykos2_table_element(uint32_t height, uint32_t index, uint8_t out[32]) {
+    uint8_t hash[32];
+    element_hash(schedule(), __builtin_bswap32(height), index, hash);
+    out[0] = 0;
+    memcpy(out + 1, hash + 1, 31);
+}
+
+bool build_autolykos2_table(uint32_t height, uint32_t count, uint8_t* out, const TableBuildOptions& options) {
+    if (!out) return false;
+    return build(height, count, options, [out](uint32_t i, const uint8_t* hash) {
+        uint8_t* e = out + (size_t)i * 32;
+        e[0] = 0;
+        memcpy(e + 1, hash + 1, 31);
+    });
 }
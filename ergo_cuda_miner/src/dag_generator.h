@@ -1,12 +1,33 @@
 // dag_generator.h
+//
+// Autolykos2 element table as the Ergo network defines it (version 2
+// headers): element i is Blake2b256(i || h || M) with its first byte
+// dropped, read as a big-endian integer, where i and the block height h are
+// 4-byte big-endian and M is the 1024 8-byte big-endian integers 0..1023.
 #ifndef DAG_GENERATOR_H
 #define DAG_GENERATOR_H
 
-#include <vector>
-#include <array>
 #include <cstdint>
+#include <functional>
 
-// Generates a simplified DAG used for Autolykos2 GPU mining
-std::vector<std::array<uint8_t, 32>> generate_full_dag();
+// Table size N for a block height: 2^26, grown by 5% every 51200 blocks
+// from height 614400 up to height 4198400
+uint32_t autolykos2_table_size(uint32_t height);
+
+// Elements finished so far and the total. Called on the building thread.
+typedef std::function<void(uint64_t done, uint64_t total)> TableProgress;
+
+struct TableBuildOptions {
+    int threads = 0;              // Builder threads, 0 = all hardware threads
+    TableProgress progress;       // May be empty
+    uint32_t progress_ms = 250;   // Interval between progress calls
+};
+
+// Element index for height as a 32-byte big-endian integer (top byte zero)
+void autolykos2_table_element(uint32_t height, uint32_t index, uint8_t out[32]);
+
+// Builds elements 0..count-1 straight into out, 32 bytes each as above
+bool build_autolykos2_table(uint32_t height, uint32_t count, uint8_t* out,
+                            const TableBuildOptions& options = TableBuildOptions());
 
 #endif // DAG_GENERATOR_H
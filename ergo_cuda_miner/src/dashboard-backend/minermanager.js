@@ -37,6 +37,11 @@ router.post('/config', (req, res) => {
   if (typeof worker === "string" && worker.length > 0) {
     dynamicConfig.worker = worker;
   }
+  // A running miner reloads its config on SIGHUP, keeping its table resident
+  if (minerProcess) {
+    writeMinerConfig();
+    minerProcess.kill('SIGHUP');
+  }
   res.json({ status: "ok", minerAddress: dynamicConfig.minerAddress, worker: dynamicConfig.worker });
 });
 
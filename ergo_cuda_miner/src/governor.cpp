@@ -0,0 +1,168 @@
+// governor.cpp
+#include "governor.h"
+#include "logger.h"
+#include "telemetry.h"
+#include <algorithm>
+#include <iomanip>
+
+static const double kMinDuty = 0.2;
+static const double kDutyStep = 0.1;
+static const uint32_t kMinBatchMs = 50;
+static const uint32_t kMaxBatchMs = 2000;
+static const double kMinGain = 0.01;
+
+static const char* knob_names[] = {"threads", "duty", "batch"};
+
+// Cumulative energy of whichever power source telemetry has, device first
+static bool read_energy(const TelemetrySnapshot& t, double& joules) {
+    if (t.flags & kTelemetryDevicePower) { joules = t.device_energy_j; return true; }
+    if (t.flags & kTelemetryCpuPower) { joules = t.cpu_energy_j; return true; }
+    return false;
+}
+
+EfficiencyGovernor::EfficiencyGovernor(const GovernorConfig& config, autolykos2_engine* engine, uint32_t batch_ms)
+    : config_(config),
+      engine_(engine),
+      max_threads_(autolykos2_engine_thread_count(engine)),
+      threads_(max_threads_),
+      batch_ms_(batch_ms)
+{
+    if (config_.window_s <= 0.0) config_.window_s = 10.0;
+    if (max_threads_ <= 1) knob_ = kDuty;  // Nothing to tune on the threads knob
+    start_window();
+    LOG_INFO("[GOVERNOR] " << (config_.mode == GovernorMode::Efficiency ? "efficiency" : "hashrate")
+             << " mode, power cap " << std::fixed << std::setprecision(0) << config_.power_cap_w
+             << " W, temp cap " << config_.temp_cap_c << " C, " << config_.window_s << " s windows");
+}
+
+void EfficiencyGovernor::start_window() {
+    hashes_ = 0;
+    window_start_ = std::chrono::steady_clock::now();
+    energy_start_j_ = 0.0;
+    read_energy(telemetry().snapshot(), energy_start_j_);
+}
+
+bool EfficiencyGovernor::measure(Measurement& m) const {
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - window_start_).count();
+    if (elapsed < config_.window_s) return false;
+    TelemetrySnapshot t = telemetry().snapshot();
+    m.rate = hashes_ / elapsed;
+    double energy;
+    if (read_energy(t, energy) && energy > energy_start_j_) m.power_w = (energy - energy_start_j_) / elapsed;
+    if (t.flags & kTelemetryDeviceTemp) m.temp_c = t.device_temp_c;
+    else if (t.flags & kTelemetryCpuTemp) m.temp_c = t.cpu_temp_c;
+    return true;
+}
+
+// Without a power reading efficiency cannot be measured, so hashrate stands in
+double EfficiencyGovernor::score(const Measurement& m) const {
+    if (config_.mode == GovernorMode::Efficiency && m.power_w > 0.0) return m.rate / m.power_w;
+    return m.rate;
+}
+
+bool EfficiencyGovernor::over_cap(const Measurement& m) const {
+    return (config_.power_cap_w > 0.0 && m.power_w > config_.power_cap_w) ||
+           (config_.temp_cap_c > 0.0 && m.temp_c > config_.temp_cap_c);
+}
+
+// Moves one knob one step. Returns false when the knob is already at its limit.
+bool EfficiencyGovernor::step(Knob knob, int dir) {
+    switch (knob) {
+    case kThreads: {
+        int want = threads_ + dir;
+        if (max_threads_ <= 1 || want < 1 || want > max_threads_) return false;
+        threads_ = autolykos2_engine_set_active_threads(engine_, want);
+        return true;
+    }
+    case kDuty: {
+        double want = duty_ + dir * kDutyStep;
+        if (want < kMinDuty - 1e-9 || want > 1.0 + 1e-9) return false;
+        duty_ = std::min(1.0, std::max(kMinDuty, want));
+        return true;
+    }
+    case kBatch: {
+        uint32_t want = dir > 0 ? batch_ms_ * 2 : batch_ms_ / 2;
+        if (want < kMinBatchMs || want > kMaxBatchMs) return false;
+        batch_ms_ = want;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool EfficiencyGovernor::step_down_any() {
+    if (step(kThreads, -1)) return true;
+    return step(kDuty, -1);
+}
+
+void EfficiencyGovernor::next_knob() {
+    knob_ = (Knob)((knob_ + 1) % kKnobCount);
+    if (knob_ == kThreads && max_threads_ <= 1) knob_ = kDuty;
+    dir_ = knob_ == kBatch ? 1 : -1;
+    tries_ = 0;
+}
+
+void EfficiencyGovernor::log(const char* what, const Measurement& m) const {
+    LOG_INFO("[GOVERNOR] " << what << ": " << std::fixed << std::setprecision(2) << m.rate << " H/s, "
+             << std::setprecision(1) << m.power_w << " W, "
+             << std::setprecision(3) << (m.power_w > 0.0 ? m.rate / m.power_w : 0.0) << " H/J, "
+             << std::setprecision(1) << m.temp_c << " C -> threads " << threads_ << "/" << max_threads_
+             << ", duty " << std::setprecision(2) << duty_ << ", batch " << batch_ms_ << " ms");
+}
+
+void EfficiencyGovernor::rebase(int threads, uint32_t batch_ms) {
+    threads_ = threads > 0 ? std::min(threads, max_threads_) : max_threads_;
+    batch_ms_ = batch_ms;
+    trial_ = false;
+    base_score_ = 0.0;
+    start_window();
+    LOG_INFO("[GOVERNOR] Rebased on reloaded settings: threads " << threads_ << "/" << max_threads_
+             << ", duty " << std::fixed << std::setprecision(2) << duty_ << ", batch " << batch_ms_ << " ms");
+}
+
+void EfficiencyGovernor::on_batch(uint64_t hashes) {
+    hashes_ += hashes;
+    Measurement m;
+    if (!measure(m)) return;
+
+    if (over_cap(m)) {
+        // Caps win over the objective; the old baseline no longer applies
+        trial_ = false;
+        base_score_ = 0.0;
+        log(step_down_any() ? "over cap, stepping down" : "over cap at minimum settings", m);
+        start_window();
+        return;
+    }
+
+    double s = score(m);
+    if (trial_) {
+        if (s > base_score_ * (1.0 + kMinGain)) {
+            base_score_ = s;
+            tries_ = 0;
+            log("kept", m);
+        } else {
+            step(knob_, -dir_);
+            dir_ = -dir_;
+            if (++tries_ >= 2) next_knob();
+            log("reverted", m);
+        }
+        trial_ = false;
+    } else {
+        base_score_ = s;
+    }
+
+    // Try the next step on the current knob, moving on when it hits a limit
+    for (int i = 0; i < 2 * kKnobCount && !trial_; ++i) {
+        if (step(knob_, dir_)) {
+            trial_ = true;
+        } else {
+            dir_ = -dir_;
+            if (++tries_ >= 2) next_knob();
+        }
+    }
+    if (trial_) {
+        LOG_DEBUG("[GOVERNOR] Trying " << knob_names[knob_] << " " << (dir_ > 0 ? "up" : "down"));
+    }
+    start_window();
+}
@@ -0,0 +1,84 @@
+// governor.h
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "autolykos2_engine.h"
+#include <chrono>
+#include <cstdint>
+
+enum class GovernorMode {
+    Off,
+    Efficiency,  // Maximize hashes per joule
+    Hashrate     // Maximize hashes per second
+};
+
+struct GovernorConfig {
+    GovernorMode mode = GovernorMode::Off;
+    double power_cap_w = 0.0;  // 0 = no cap
+    double temp_cap_c = 0.0;   // 0 = no cap
+    double window_s = 10.0;    // Measurement window per setting
+};
+
+// Tunes active worker threads, duty cycle and batch length by coordinate
+// ascent on hashes per joule (or hashes per second), using the telemetry
+// sampler for power and temperature. Each window measures one setting; a
+// step that does not improve the score by more than 1% is reverted and the
+// next knob is tried. Exceeding a cap always steps a knob down.
+// Driven from the mining thread only.
+class EfficiencyGovernor {
+public:
+    EfficiencyGovernor(const GovernorConfig& config, autolykos2_engine* engine, uint32_t batch_ms);
+
+    // Accounts one finished batch and retunes at the end of each window
+    void on_batch(uint64_t hashes);
+
+    // Fraction of wall time the engine should be hashing (0.2 .. 1.0)
+    double duty() const { return duty_; }
+
+    // Batch wall-time target for the batch sizer
+    uint32_t batch_ms() const { return batch_ms_; }
+
+    // Active worker threads the governor has set
+    int threads() const { return threads_; }
+
+    // Threads (0 = all) and batch length were changed from outside, by a
+    // config reload: they become the new baseline and measuring restarts
+    void rebase(int threads, uint32_t batch_ms);
+
+private:
+    enum Knob { kThreads, kDuty, kBatch, kKnobCount };
+
+    struct Measurement {
+        double rate = 0.0;     // H/s over the window
+        double power_w = 0.0;  // 0 when unknown
+        double temp_c = 0.0;   // 0 when unknown
+    };
+
+    void start_window();
+    bool measure(Measurement& m) const;
+    double score(const Measurement& m) const;
+    bool over_cap(const Measurement& m) const;
+    bool step(Knob knob, int dir);
+    bool step_down_any();
+    void next_knob();
+    void log(const char* what, const Measurement& m) const;
+
+    GovernorConfig config_;
+    autolykos2_engine* engine_;
+    int max_threads_;
+    int threads_;
+    double duty_ = 1.0;
+    uint32_t batch_ms_;
+
+    Knob knob_ = kThreads;
+    int dir_ = -1;            // Fewer threads first: memory-bound hashing often gains H/J
+    int tries_ = 0;           // Directions tried on the current knob without a gain
+    bool trial_ = false;      // The current window measures an untested step
+    double base_score_ = 0.0;
+
+    uint64_t hashes_ = 0;
+    std::chrono::steady_clock::time_point window_start_;
+    double energy_start_j_ = 0.0;
+};
+
+#endif // GOVERNOR_H
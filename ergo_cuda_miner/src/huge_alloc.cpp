@@ -0,0 +1,113 @@
+// huge_alloc.cpp
+#include "huge_alloc.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+static const size_t kPage4K = 4096;
+static const size_t kPage2M = 2UL << 20;
+static const size_t kPage1G = 1UL << 30;
+
+static size_t round_up(size_t size, size_t page) {
+    return (size + page - 1) / page * page;
+}
+
+static void* map_hugetlb(size_t size, int size_flag) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+static bool thp_enabled() {
+    std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    std::getline(f, line);
+    return !line.empty() && line.find("[never]") == std::string::npos;
+}
+
+HugeAllocation huge_alloc(size_t size) {
+    HugeAllocation a;
+    if (size == 0) return a;
+
+    size_t size_1g = round_up(size, kPage1G);
+    if (size_1g - size < size_1g / 4) {
+        if (void* p = map_hugetlb(size_1g, MAP_HUGE_1GB)) {
+            a.ptr = p; a.mapped_size = size_1g; a.page_size = kPage1G; a.kind = "hugetlb-1g";
+            return a;
+        }
+    }
+
+    size_t size_2m = round_up(size, kPage2M);
+    if (void* p = map_hugetlb(size_2m, MAP_HUGE_2MB)) {
+        a.ptr = p; a.mapped_size = size_2m; a.page_size = kPage2M; a.kind = "hugetlb-2m";
+        return a;
+    }
+
+    // Over-map by one huge page so the usable range can be 2 MB aligned for THP
+    size_t span = size_2m + kPage2M;
+    void* raw = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return a;
+    uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (base + kPage2M - 1) & ~(uintptr_t)(kPage2M - 1);
+    if (aligned > base) munmap(raw, aligned - base);
+    uintptr_t tail = aligned + size_2m;
+    if (base + span > tail) munmap(reinterpret_cast<void*>(tail), base + span - tail);
+
+    a.ptr = reinterpret_cast<void*>(aligned);
+    a.mapped_size = size_2m;
+#ifdef MADV_HUGEPAGE
+    if (thp_enabled() && madvise(a.ptr, size_2m, MADV_HUGEPAGE) == 0) {
+        a.page_size = kPage4K; a.kind = "thp-requested";
+        return a;
+    }
+#endif
+    a.page_size = kPage4K; a.kind = "4k";
+    return a;
+}
+
+// Sums AnonHugePages of the smaps entries inside [begin, end)
+static size_t anon_huge_bytes(uintptr_t begin, uintptr_t end) {
+    std::ifstream f("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    size_t bytes = 0;
+    while (std::getline(f, line)) {
+        unsigned long lo, hi;
+        if (sscanf(line.c_str(), "%lx-%lx ", &lo, &hi) == 2 && line.find(':') > line.find(' ')) {
+            inside = lo < end && hi > begin;
+            continue;
+        }
+        size_t kb;
+        if (inside && sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1) bytes += kb * 1024;
+    }
+    return bytes;
+}
+
+size_t huge_confirm_thp(HugeAllocation& alloc) {
+    if (!alloc.ptr || (strcmp(alloc.kind, "thp-requested") != 0 && strcmp(alloc.kind, "thp") != 0)) return 0;
+    uintptr_t begin = reinterpret_cast<uintptr_t>(alloc.ptr);
+    size_t bytes = std::min(anon_huge_bytes(begin, begin + alloc.mapped_size), alloc.mapped_size);
+    bool all = bytes == alloc.mapped_size;
+    alloc.page_size = all ? kPage2M : kPage4K;
+    alloc.kind = all ? "thp" : "thp-requested";
+    return bytes;
+}
+
+void huge_free(HugeAllocation& alloc) {
+    if (alloc.ptr) munmap(alloc.ptr, alloc.mapped_size);
+    alloc = HugeAllocation{};
+}
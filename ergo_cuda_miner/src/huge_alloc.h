@@ -0,0 +1,31 @@
+// huge_alloc.h
+#ifndef HUGE_ALLOC_H
+#define HUGE_ALLOC_H
+
+#include <cstddef>
+
+struct HugeAllocation {
+    void* ptr = nullptr;
+    size_t mapped_size = 0;   // Bytes actually mapped (rounded to page size)
+    size_t page_size = 0;     // Page size backing the mapping
+    const char* kind = "none"; // "hugetlb-1g", "hugetlb-2m", "thp", "thp-requested", "4k"
+};
+
+// Maps size bytes backed by the largest page size available, trying in order:
+// 1 GB hugetlbfs pages (only when rounding wastes under a quarter of the
+// mapping), 2 MB hugetlbfs pages, transparent huge pages via madvise, and
+// finally normal pages. Memory is not touched, so NUMA first-touch placement
+// still applies. Returns an allocation with ptr == nullptr on failure.
+// The kernel may still back a madvised range with 4 KB pages, so it is
+// reported as "thp-requested" with 4 KB pages until huge_confirm_thp.
+HugeAllocation huge_alloc(size_t size);
+
+// For a "thp-requested" allocation whose memory has been written, reads
+// AnonHugePages for it from /proc/self/smaps. A mapping backed entirely
+// by huge pages becomes "thp" with 2 MB pages. Returns the bytes on
+// transparent huge pages (0 for other kinds).
+size_t huge_confirm_thp(HugeAllocation& alloc);
+
+void huge_free(HugeAllocation& alloc);
+
+#endif // HUGE_ALLOC_H
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# kat_gen.py
+#
+# Writes autolykos2_kat.json, the known-answer corpus checked by
+# `miner --selftest`. Everything here is computed from the algorithm's
+# definition with hashlib and plain integers, sharing no code with the
+# miner, so the corpus catches mistakes the C++ paths would agree on.
+#
+# Usage: python3 kat_gen.py [output]
+
+import hashlib
+import json
+import random
+import sys
+
+MASK64 = (1 << 64) - 1
+HEADER_SIZE = 76
+K_LEN = 64
+
+IV = [
+    0x6A09E667F3BCC908, 0xBB67AE8584CAA73B, 0x3C6EF372FE94F82B, 0xA54FF53A5F1D36F1,
+    0x510E527FADE682D1, 0x9B05688C2B3E6C1F, 0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179,
+]
+
+SIGMA = [
+    [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15],
+    [14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3],
+    [11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4],
+    [7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8],
+    [9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13],
+    [2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9],
+    [12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11],
+    [13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10],
+    [6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5],
+    [10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0],
+]
+
+
+def blake2b256(data):
+    return hashlib.blake2b(data, digest_size=32).digest()
+
+
+def rotr64(x, n):
+    return ((x >> n) | (x << (64 - n))) & MASK64
+
+
+def mix(v, m):
+    def g(a, b, c, d, x, y):
+        v[a] = (v[a] + v[b] + x) & MASK64
+        v[d] = rotr64(v[d] ^ v[a], 32)
+        v[c] = (v[c] + v[d]) & MASK64
+        v[b] = rotr64(v[b] ^ v[c], 24)
+        v[a] = (v[a] + v[b] + y) & MASK64
+        v[d] = rotr64(v[d] ^ v[a], 16)
+        v[c] = (v[c] + v[d]) & MASK64
+        v[b] = rotr64(v[b] ^ v[c], 63)
+
+    for r in range(12):
+        s = SIGMA[r % 10]
+        g(0, 4, 8, 12, m[s[0]], m[s[1]])
+        g(1, 5, 9, 13, m[s[2]], m[s[3]])
+        g(2, 6, 10, 14, m[s[4]], m[s[5]])
+        g(3, 7, 11, 15, m[s[6]], m[s[7]])
+        g(0, 5, 10, 15, m[s[8]], m[s[9]])
+        g(1, 6, 11, 12, m[s[10]], m[s[11]])
+        g(2, 7, 8, 13, m[s[12]], m[s[13]])
+        g(3, 4, 9, 14, m[s[14]], m[s[15]])
+
+
+def seed_words(hash1, nonce):
+    # One Blake2b-256 compression of hash1 || nonce (big-endian), except
+    # that v[8..15] start from the parameter-xored IV, as the miner's
+    # CUDA kernel has always done
+    h = list(IV)
+    h[0] ^= 0x01010020
+    v = h + h
+    v[12] ^= 40
+    v[14] ^= MASK64
+    block = hash1 + nonce.to_bytes(8, "big") + bytes(88)
+    m = [int.from_bytes(block[8 * i:8 * i + 8], "little") for i in range(16)]
+    mix(v, m)
+    r = []
+    for j in range(4):
+        w = h[j] ^ v[j] ^ v[8 + j]
+        r += [w & 0xFFFFFFFF, w >> 32]
+    return r
+
+
+def rotl32(x, n):
+    return ((x << n) | (x >> (32 - n))) & 0xFFFFFFFF if n else x
+
+
+def element(seed, idx):
+    return int.from_bytes(blake2b256(seed + idx.to_bytes(4, "little"))[:4], "little")
+
+
+def pow_hash(seed, table_bits, header, nonce):
+    hash1 = blake2b256(header + nonce.to_bytes(8, "little"))
+    r = seed_words(hash1, nonce)
+    mask = (1 << table_bits) - 1
+    ind = [rotl32(r[(k // 4) % 8], 8 * (k % 4)) & mask for k in range(K_LEN)]
+    total = sum(element(seed, i) for i in ind) & MASK64
+    return ind, blake2b256(hash1 + total.to_bytes(8, "little"))
+
+
+# Network element table (dag_generator.h)
+M = b"".join(i.to_bytes(8, "big") for i in range(1024))
+
+
+def table_element(height, index):
+    return b"\0" + blake2b256(index.to_bytes(4, "big") + height.to_bytes(4, "big") + M)[1:]
+
+
+def table_size(height):
+    height = min(height, 4198400)
+    if height < 600 * 1024:
+        return 1 << 26
+    n = 1 << 26
+    for _ in range((height - 600 * 1024) // (50 * 1024) + 1):
+        n = n // 100 * 105
+    return n
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else "autolykos2_kat.json"
+    rng = random.Random(2024)
+    zero = bytes(32)
+
+    hashes = []
+    cases = []
+    # The seed the miner builds its dataset from, at the self-test and
+    # mainnet table sizes, including nonces whose low word carries
+    for bits in (18, 26):
+        for nonce in (0, 1, 0xFFFFFFFF, 0x100000000, 0xFFFFFFFFFFFFFFFF):
+            cases.append((zero, bits, bytes(HEADER_SIZE), nonce))
+        for _ in range(8):
+            cases.append((zero, bits, rng.randbytes(HEADER_SIZE), rng.getrandbits(64)))
+    # Other seeds and table sizes
+    for bits in (10, 20, 27):
+        for _ in range(4):
+            cases.append((rng.randbytes(32), bits, rng.randbytes(HEADER_SIZE), rng.getrandbits(64)))
+
+    for seed, bits, header, nonce in cases:
+        ind, h = pow_hash(seed, bits, header, nonce)
+        hashes.append({
+            "seed": seed.hex(),
+            "table_bits": bits,
+            "header": header.hex(),
+            "nonce": "%016x" % nonce,
+            "indices": ind,
+            "hash": h.hex(),
+        })
+
+    elements = []
+    for height in (0, 614400, 1000000):
+        for index in (0, 1, 12345, (1 << 26) - 1):
+            elements.append({"height": height, "index": index, "element": table_element(height, index).hex()})
+
+    sizes = [{"height": h, "size": table_size(h)}
+             for h in (0, 614399, 614400, 665600, 1000000, 4198400, 5000000)]
+
+    # One vector per line keeps the corpus diffable
+    with open(out, "w") as f:
+        sections = [("hashes", hashes), ("elements", elements), ("table_sizes", sizes)]
+        f.write("{\n")
+        for n, (name, vectors) in enumerate(sections):
+            f.write(' "%s": [\n' % name)
+            f.write(",\n".join("  " + json.dumps(v) for v in vectors))
+            f.write("\n ]%s\n" % ("," if n + 1 < len(sections) else ""))
+        f.write("}\n")
+    print("Wrote %d hash, %d element and %d table size vectors to %s" % (len(hashes), len(elements), len(sizes), out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,170 @@
+// logger.cpp
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+std::atomic<int> g_log_level{(int)LogLevel::Info};
+
+// Lines held before producers start dropping
+static constexpr size_t kQueueSize = 1u << 12;
+
+namespace {
+
+// Bounded multi-producer queue (Vyukov): each slot's sequence number says
+// whether it is free for the producer at that position or holds a line for
+// the consumer. Producers claim positions with one CAS and never wait.
+struct LogQueue {
+    struct Slot {
+        std::atomic<size_t> seq;
+        LogLevel level;
+        std::string line;
+    };
+
+    std::unique_ptr<Slot[]> slots{new Slot[kQueueSize]};
+    alignas(64) std::atomic<size_t> tail{0};  // Next position to write
+    alignas(64) size_t head = 0;              // Next position to read (writer thread only)
+
+    LogQueue() {
+        for (size_t i = 0; i < kQueueSize; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(LogLevel level, std::string& line) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = slots[pos & (kQueueSize - 1)];
+            size_t seq = s.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.level = level;
+                    s.line.swap(line);
+                    s.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(LogLevel& level, std::string& line) {
+        Slot& s = slots[head & (kQueueSize - 1)];
+        if (s.seq.load(std::memory_order_acquire) != head + 1) return false;
+        level = s.level;
+        line.swap(s.line);
+        s.line.clear();
+        s.seq.store(head + kQueueSize, std::memory_order_release);
+        ++head;
+        return true;
+    }
+};
+
+LogQueue g_queue;
+std::atomic<bool> g_async{false};
+std::atomic<bool> g_stop{false};
+std::atomic<uint64_t> g_dropped{0};
+std::thread g_writer;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void emit(LogLevel level, const std::string& line) {
+    FILE* f = level >= LogLevel::Warn ? stderr : stdout;
+    fwrite(line.data(), 1, line.size(), f);
+    fputc('\n', f);
+}
+
+// Drains whatever is queued, then flushes once for the whole batch
+bool drain() {
+    LogLevel level;
+    std::string line;
+    bool any = false;
+    while (g_queue.pop(level, line)) {
+        emit(level, line);
+        any = true;
+    }
+    uint64_t dropped = g_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped) {
+        fprintf(stderr, "[LOG] Queue full, dropped %llu lines\n", (unsigned long long)dropped);
+        any = true;
+    }
+    if (any) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    return any;
+}
+
+void writer_loop() {
+    while (!g_stop.load(std::memory_order_acquire)) {
+        if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    drain();
+}
+
+} // namespace
+
+void log_set_level(LogLevel level) {
+    g_log_level.store((int)level, std::memory_order_relaxed);
+}
+
+LogLevel log_level() {
+    return (LogLevel)g_log_level.load(std::memory_order_relaxed);
+}
+
+bool log_parse_level(const std::string& name, LogLevel& level) {
+    static const char* names[] = {"trace", "debug", "info", "warn", "error", "off"};
+    for (int i = 0; i <= (int)LogLevel::Off; ++i) {
+        if (name == names[i]) {
+            level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void log_start() {
+    if (g_writer.joinable()) return;
+    // Lines printed directly by other modules are only ordered against
+    // ours at flush points, so flush them before the first queued line
+    fflush(stdout);
+    g_stop = false;
+    g_writer = std::thread(writer_loop);
+    g_async = true;
+}
+
+void log_stop() {
+    if (!g_writer.joinable()) return;
+    g_async = false;
+    g_stop.store(true, std::memory_order_release);
+    g_writer.join();
+    drain();  // Lines pushed by producers that raced with the shutdown
+}
+
+void log_write(LogLevel level, std::string line) {
+    if (g_async.load(std::memory_order_acquire)) {
+        if (g_queue.push(level, line)) return;
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    emit(level, line);
+    fflush(level >= LogLevel::Warn ? stderr : stdout);
+}
+
+bool LogRateLimit::allow(uint32_t interval_ms, uint64_t& suppressed) {
+    int64_t now = now_ns();
+    int64_t next = next_ns_.load(std::memory_order_relaxed);
+    if (now < next || !next_ns_.compare_exchange_strong(next, now + (int64_t)interval_ms * 1000000,
+                                                        std::memory_order_relaxed)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
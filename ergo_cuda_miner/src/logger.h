@@ -0,0 +1,91 @@
+// logger.h
+//
+// Leveled diagnostic logging. Messages are formatted on the calling thread
+// only when their level is enabled, pushed onto a lock-free queue and
+// written by a background thread, so I/O threads never block on the console.
+// Messages keep their own "[TAG]" prefixes; the dashboard parses them.
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+enum class LogLevel : int { Trace = 0, Debug, Info, Warn, Error, Off };
+
+// Levels below this are compiled out (make LOG_LEVEL=2 keeps Info and up)
+#ifndef CORTEX_LOG_MIN_LEVEL
+#define CORTEX_LOG_MIN_LEVEL 0
+#endif
+
+extern std::atomic<int> g_log_level;
+
+inline bool log_enabled(LogLevel level) {
+    return (int)level >= CORTEX_LOG_MIN_LEVEL &&
+           (int)level >= g_log_level.load(std::memory_order_relaxed);
+}
+
+void log_set_level(LogLevel level);
+LogLevel log_level();
+
+// "trace", "debug", "info", "warn", "error" or "off". Returns false and
+// leaves level unchanged on anything else.
+bool log_parse_level(const std::string& name, LogLevel& level);
+
+// Starts the writer thread. Until then, and after log_stop(), messages are
+// written synchronously.
+void log_start();
+
+// Writes everything still queued and joins the writer
+void log_stop();
+
+// Queues one line (without trailing newline). Warn and Error go to stderr,
+// the rest to stdout. Never blocks: if the queue is full the line is
+// dropped and counted.
+void log_write(LogLevel level, std::string line);
+
+// Per-call-site limiter: lets one message through every interval_ms and
+// counts the ones it holds back.
+class LogRateLimit {
+public:
+    // True if a message may be logged now; suppressed receives the number
+    // of messages dropped since the last one that got through
+    bool allow(uint32_t interval_ms, uint64_t& suppressed);
+
+private:
+    std::atomic<int64_t> next_ns_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+#define CORTEX_LOG(level, expr)                                   \
+    do {                                                          \
+        if (log_enabled(level)) {                                 \
+            std::ostringstream cortex_log_os_;                    \
+            cortex_log_os_ << expr;                               \
+            log_write(level, cortex_log_os_.str());               \
+        }                                                         \
+    } while (0)
+
+// At most one message per interval_ms from this call site
+#define CORTEX_LOG_EVERY_MS(level, interval_ms, expr)                          \
+    do {                                                                       \
+        static LogRateLimit cortex_log_limit_;                                 \
+        uint64_t cortex_log_dropped_;                                          \
+        if (log_enabled(level) &&                                              \
+            cortex_log_limit_.allow(interval_ms, cortex_log_dropped_)) {       \
+            std::ostringstream cortex_log_os_;                                 \
+            cortex_log_os_ << expr;                                            \
+            if (cortex_log_dropped_)                                           \
+                cortex_log_os_ << " (" << cortex_log_dropped_ << " suppressed)"; \
+            log_write(level, cortex_log_os_.str());                            \
+        }                                                                      \
+    } while (0)
+
+#define LOG_TRACE(expr) CORTEX_LOG(LogLevel::Trace, expr)
+#define LOG_DEBUG(expr) CORTEX_LOG(LogLevel::Debug, expr)
+#define LOG_INFO(expr) CORTEX_LOG(LogLevel::Info, expr)
+#define LOG_WARN(expr) CORTEX_LOG(LogLevel::Warn, expr)
+#define LOG_ERROR(expr) CORTEX_LOG(LogLevel::Error, expr)
+
+#endif // LOGGER_H
@@ -1,12 +1,29 @@
 
 #include <iostream>
 #include <fstream>
+#include <future>
+#include <iomanip>
 #include <sstream>
 #include <thread>
 #include <chrono>
+#include <cstdlib>
+#include <memory>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 #include "stratum_client.h"
+#include "autotune.h"
+#include "bench.h"
+#include "config_watcher.h"
+#include "dag_generator.h"
+#include "governor.h"
+#include "huge_alloc.h"
+#include "logger.h"
+#include "selftest.h"
+#include "stratum_session.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "autolykos2_engine.h"
+#include "autolykos2_params.h"
 
 using json = nlohmann::json;
 
@@ -81,13 +98,16 @@ void log_nonce_range(int gpu, uint64_t start, uint64_t end, double conf) {
     log.close();
 }
 
+// Reads the in-process telemetry sampler. Device readings win when a device
+// backend is running; otherwise the host CPU package stands in.
 GpuStats fetch_gpu_stats(int index) {
-    std::string apiServer = "http://localhost:4201";
-    std::string endpoint = apiServer + "/api/gpu/stats";
-    std::string raw = http_get(endpoint);
-    auto parsed = json::parse(raw);
-    auto g = parsed["gpus"][index];
-    return { g["temp"], g["util"], g["power"] };
+    (void)index;  // The sampler watches the engine's own device
+    TelemetrySnapshot t = telemetry().snapshot();
+    GpuStats stats{0.0f, 0.0f, 0.0f};
+    stats.temp = (float)((t.flags & kTelemetryDeviceTemp) ? t.device_temp_c : t.cpu_temp_c);
+    stats.util = (float)((t.flags & kTelemetryDeviceUtil) ? t.device_util : t.cpu_util);
+    stats.power = (float)((t.flags & kTelemetryDevicePower) ? t.device_power_w : t.cpu_power_w);
+    return stats;
 }
 
 NonceRange get_nonce_range_from_ai(int gpuIndex, uint64_t currentNonce, int height, double difficulty) {
@@ -119,11 +139,258 @@ bool mine_autolykos_gpu(const std::string& header, const std::string& target,
     return false;
 }
 
+// Replays a recorded session through the client and prints the report
+static int run_replay(StratumClient& client, const std::string& path, double speed) {
+    std::vector<SessionEvent> events;
+    if (!load_session(path, events)) return 1;
+    std::cout << "[REPLAY] " << events.size() << " events from " << path << " at ";
+    if (speed > 0) std::cout << speed << "x speed\n";
+    else std::cout << "max speed\n";
+    ReplayReport r;
+    if (!replay_session(client, events, speed, r)) return 1;
+    log_stop();  // The session's queued lines go out before the report
+    std::cout << "[REPLAY] Pool lines: " << r.pool_lines
+              << " | Job switches: " << r.job_switches
+              << " | Switch latency avg/max: " << r.switch_latency_avg_ms << "/" << r.switch_latency_max_ms << " ms\n"
+              << "[REPLAY] Stale batches: " << r.stale_batches << " (" << r.stale_nonces << " nonces)"
+              << " | Shares submitted: " << r.shares_submitted << "\n"
+              << "[REPLAY] Wall: " << r.wall_seconds << " s | CPU: " << r.cpu_seconds << " s ("
+              << (r.wall_seconds > 0 ? 100.0 * r.cpu_seconds / r.wall_seconds : 0.0) << "% of one core)\n";
+    return 0;
+}
+
+// Builds the network's element table for height and writes it to path,
+// 32 bytes per element. count 0 builds the full table.
+static int run_build_table(uint32_t height, uint32_t count, const std::string& path) {
+    if (count == 0) count = autolykos2_table_size(height);
+    size_t bytes = (size_t)count * 32;
+    HugeAllocation mem = huge_alloc(bytes);
+    if (!mem.ptr) {
+        std::cerr << "[DAG] Cannot allocate " << bytes / 1048576 << " MB for the table\n";
+        return 1;
+    }
+    std::cout << "[DAG] Building " << count << " elements for height " << height << "\n";
+
+    TableBuildOptions options;
+    options.progress = [](uint64_t done, uint64_t total) {
+        printf("[DAG] Table build: %.1f%%\n", 100.0 * done / total);
+        fflush(stdout);
+    };
+    auto t0 = std::chrono::steady_clock::now();
+    build_autolykos2_table(height, count, (uint8_t*)mem.ptr, options);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "[DAG] Built in " << secs << " s (" << count / secs / 1e6 << " M elements/s)\n";
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char*)mem.ptr, bytes);
+    huge_free(mem);
+    if (!out) {
+        std::cerr << "[DAG] Cannot write " << path << "\n";
+        return 1;
+    }
+    std::cout << "[DAG] Wrote " << path << "\n";
+    return 0;
+}
+
+// Runs the synthetic benchmark on a ready engine. The "bench" config block
+// sets its parameters; the JSON result is the last line on stdout and is
+// also written to bench.output when that is set.
+static int run_bench_mode(const json& cfg, autolykos2_engine* engine, const autolykos2_engine_config& engineCfg,
+                          double tableBuildS, const std::string& profileKey) {
+    json b = cfg.contains("bench") ? cfg["bench"] : json::object();
+    BenchConfig config;
+    config.seconds = b.value("seconds", config.seconds);
+    config.difficulty = b.value("difficulty", config.difficulty);
+    config.job_s = b.value("job_s", config.job_s);
+    config.batch_ms = cfg.value("batch_ms", config.batch_ms);
+    config.seed = b.value("seed", config.seed);
+    config.profile_nonces = b.value("profile_nonces", config.profile_nonces);
+    if (config.seconds <= 0.0 || config.difficulty < 1.0) {
+        std::cerr << "[BENCH] Need seconds > 0 and difficulty >= 1\n";
+        return 1;
+    }
+
+    BenchContext context;
+    context.table_bits = engineCfg.table_bits ? engineCfg.table_bits : AUTOLYKOS2_N;
+    context.table_build_s = tableBuildS;
+    context.profile = profileKey;
+    std::string result = run_bench(engine, config, context);
+    std::cout << result << std::endl;
+
+    std::string output = b.value("output", "");
+    if (!output.empty()) {
+        std::ofstream out(output, std::ios::trunc);
+        out << result << "\n";
+        if (!out) {
+            std::cerr << "[BENCH] Cannot write " << output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Checks every hashing path against the reference and the known-answer
+// corpus, as set by the "selftest" config block. The JSON result is the
+// last line on stdout and is also written to selftest.output when set.
+static int run_selftest_mode(const json& cfg) {
+    json t = cfg.contains("selftest") ? cfg["selftest"] : json::object();
+    SelftestConfig config;
+    config.kat_file = t.value("kat", config.kat_file);
+    config.table_bits = t.value("table_bits", config.table_bits);
+    config.threads = cfg.value("threads", config.threads);
+    config.cuda = t.value("cuda", config.cuda);
+    config.cuda_device = cfg.value("device", config.cuda_device);
+    config.ranges = t.value("ranges", config.ranges);
+    config.seed = t.value("seed", config.seed);
+    config.throughput_s = t.value("throughput_s", config.throughput_s);
+    if (config.table_bits == 0 || config.table_bits > 31) {
+        std::cerr << "[SELFTEST] table_bits must be 1-31\n";
+        return 1;
+    }
+
+    bool passed = false;
+    std::string result = run_selftest(config, passed);
+    std::cout << result << std::endl;
+
+    std::string output = t.value("output", "");
+    if (!output.empty()) {
+        std::ofstream out(output, std::ios::trunc);
+        out << result << "\n";
+        if (!out) {
+            std::cerr << "[SELFTEST] Cannot write " << output << "\n";
+            return 1;
+        }
+    }
+    return passed ? 0 : 1;
+}
+
+// Startup and reloads authorize with the same password
+static std::string pool_password(const json& pool) {
+    return pool.value("password", "x");
+}
+
+static json config_entry(const json& cfg, const char* key) {
+    return cfg.contains(key) ? cfg[key] : json();
+}
+
+// "log_level": "trace" | "debug" | "info" (default) | "warn" | "error" | "off"
+static void apply_log_level(const json& cfg) {
+    std::string name = cfg.value("log_level", "info");
+    LogLevel level;
+    if (log_parse_level(name, level)) {
+        log_set_level(level);
+    } else {
+        std::cerr << "[CONFIG] Unknown log_level '" << name << "', keeping the current level\n";
+    }
+}
+
+// Applies a rewritten config.json to the running miner. The engine keeps its
+// dataset and worker threads; only pool or credential changes reconnect.
+static void reload_config(json& cfg, StratumClient& client, EngineProfile& tuning) {
+    json next;
+    try {
+        next = json::parse(read_file("config.json"));
+    } catch (const std::exception& e) {
+        std::cerr << "[CONFIG] Reload failed, keeping current settings: " << e.what() << "\n";
+        return;
+    }
+    std::cout << "[CONFIG] Reloading config.json\n";
+    auto changed = [&](const char* key) { return config_entry(next, key) != config_entry(cfg, key); };
+
+    for (const char* key : {"engine", "device", "table_bits", "telemetry_ms", "record_session",
+                            "governor", "profile_cache", "trace_file",
+                            "worker_id", "worker_id_bits", "share_rate"}) {
+        if (changed(key)) std::cout << "[CONFIG] '" << key << "' changed; takes effect after a restart\n";
+    }
+
+    // "threads" sized the worker pool at startup; live it sets how many of
+    // them hash. The mining thread applies engine and batch changes between
+    // batches, feeding them to the governor when one runs.
+    LiveTuning live;
+    if (changed("threads") || changed("interleave")) {
+        tuning.threads = next.value("threads", 0);
+        tuning.interleave = next.value("interleave", 0u);
+        live.retune = true;
+        live.threads = tuning.threads;
+        live.interleave = tuning.interleave;
+        live.isa = tuning.isa;
+    }
+    if (changed("batch_ms")) live.batch_ms = next.value("batch_ms", 250u);
+    if (live.retune || live.batch_ms) client.set_live_tuning(live);
+    if (changed("log_level")) apply_log_level(next);
+    if (changed("verify_shares")) client.set_verify_shares(next.value("verify_shares", true));
+    if (changed("share_queue_size")) client.set_share_queue_size(next.value("share_queue_size", 64u));
+    if (changed("stats_window_s") || changed("metrics_file")) {
+        client.set_share_stats(next.value("stats_window_s", 600.0), next.value("metrics_file", ""));
+    }
+
+    if (changed("pool") || changed("address")) {
+        try {
+            std::string address = next["address"];
+            const json& pool = next["pool"];
+            std::string worker = address + "." + pool["worker"].get<std::string>();
+            std::cout << "[CONFIG] Pool settings changed, reconnecting to "
+                      << pool["host"].get<std::string>() << ":" << pool["port"].get<int>() << "\n";
+            client.set_pool(pool["host"], pool["port"], pool.value("ssl", false), worker,
+                            pool_password(pool), address);
+        } catch (const std::exception& e) {
+            std::cerr << "[CONFIG] Invalid pool settings, keeping the current pool: " << e.what() << "\n";
+            next["pool"] = cfg["pool"];
+            next["address"] = cfg["address"];
+        }
+    }
+    cfg = next;
+}
+
 // ---------- Main ----------
-int main() {
-    std::cout << "[MAIN] Starting POOL mining mode...\n";
+int main(int argc, char** argv) {
+    // --replay <session> [--speed <factor>] feeds a recorded session instead of connecting;
+    // --autotune benchmarks the engine, caches the best profile and exits;
+    // --build-table writes the network's element table for a height and exits;
+    // --bench mines synthetic jobs for a fixed time and prints the results as JSON;
+    // --selftest checks every engine against the reference and exits non-zero on a mismatch
+    std::string replayPath;
+    double replaySpeed = 1.0;
+    bool autotune = false;
+    bool bench = false;
+    bool selftest = false;
+    std::string tablePath;
+    uint32_t tableHeight = 0, tableCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--autotune") {
+            autotune = true;
+        } else if (arg == "--bench") {
+            bench = true;
+        } else if (arg == "--selftest") {
+            selftest = true;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            replaySpeed = atof(argv[++i]);
+        } else if (arg == "--build-table" && i + 2 < argc) {
+            tableHeight = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            tablePath = argv[++i];
+        } else if (arg == "--table-count" && i + 1 < argc) {
+            tableCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--autotune] [--bench] [--selftest] [--replay <session> [--speed <factor>]]"
+                      << " [--build-table <height> <file> [--table-count <n>]]\n";
+            return 1;
+        }
+    }
+    if (!tablePath.empty()) return run_build_table(tableHeight, tableCount, tablePath);
+    if (selftest) {
+        json cfg = json::parse(read_file("config.json"));
+        apply_log_level(cfg);
+        return run_selftest_mode(cfg);
+    }
+
+    std::cout << (replayPath.empty() ? "[MAIN] Starting POOL mining mode...\n"
+                                     : "[MAIN] Starting session replay...\n");
 
     json cfg = json::parse(read_file("config.json"));
+    apply_log_level(cfg);
     std::string minerAddress = cfg["address"];
     std::string workerName = cfg["pool"]["worker"];
     std::string poolHost = cfg["pool"]["host"];
@@ -136,8 +403,152 @@ int main() {
               << ", port: " << poolPort
               << ", worker: " << fullWorker << "\n";
 
-    StratumClient client(poolHost, poolPort, useSSL, fullWorker, "x", minerAddress);
-    client.run();
+    // Hashing engine: "cuda" (default) or "cpu"
+    std::string engineKind = cfg.value("engine", "cuda");
+    autolykos2_engine_config engineCfg{};
+    engineCfg.kind = (engineKind == "cpu") ? AUTOLYKOS2_ENGINE_CPU : AUTOLYKOS2_ENGINE_CUDA;
+    engineCfg.device_id = cfg.value("device", 0);
+    engineCfg.threads = cfg.value("threads", 0);
+    engineCfg.table_bits = cfg.value("table_bits", 0);
+    engineCfg.interleave = cfg.value("interleave", 0);
+    autolykos2_engine* engine = autolykos2_engine_create(&engineCfg);
+    if (!engine) {
+        std::cerr << "[MAIN] Failed to create " << engineKind << " engine\n";
+        return 1;
+    }
 
-    return 0;
+    // Per-host tuned profile, written by --autotune. Applied before the
+    // dataset build so the build runs with the tuned worker pool.
+    std::string profileCache = cfg.value("profile_cache", "autotune_profiles.json");
+    std::string profileKey = profile_key(engine, engineCfg.table_bits ? engineCfg.table_bits : AUTOLYKOS2_N);
+    uint32_t batchMs = cfg.value("batch_ms", 250);
+    EngineProfile profile;
+    if (!autotune && cfg.value("use_profile", true) && load_profile(profileCache, profileKey, profile)) {
+        if (apply_profile(engine, profile)) {
+            batchMs = profile.batch_ms;
+            std::cout << "[AUTOTUNE] Loaded profile " << profileKey << " (" << profile.hashrate << " H/s when tuned)\n";
+        }
+    }
+
+    // Startup stages overlap: the dataset builds in the background while
+    // telemetry comes up and the client connects, subscribes and authorizes.
+    // Notifies arriving meanwhile are held as the current job, and the
+    // mining thread starts hashing once the dataset is ready.
+    std::cout << "[*] Generating DAG on " << autolykos2_engine_name(engine) << "...\n";
+    double tableBuildS = 0.0;
+    std::shared_future<bool> datasetReady = std::async(std::launch::async, [engine, &tableBuildS] {
+        uint8_t seed[32] = {0};
+        auto tableStart = std::chrono::steady_clock::now();
+        if (!autolykos2_engine_generate_dataset(engine, seed)) {
+            LOG_ERROR("[MAIN] Dataset generation failed");
+            return false;
+        }
+        tableBuildS = std::chrono::duration<double>(std::chrono::steady_clock::now() - tableStart).count();
+        LOG_INFO("[*] DAG ready in " << std::fixed << std::setprecision(1) << tableBuildS << " s");
+        return true;
+    }).share();
+
+    // Hardware telemetry for logs, advisors and the periodic [GPU] report
+    telemetry().add_backend(make_sysfs_telemetry());
+    if (engineCfg.kind == AUTOLYKOS2_ENGINE_CUDA) {
+        telemetry().add_backend(make_nvml_telemetry(engineCfg.device_id));
+    }
+    telemetry().start(cfg.value("telemetry_ms", 1000));
+
+    // Benchmarks and replays time the engine, so they start on a finished dataset
+    if ((autotune || bench || !replayPath.empty()) && !datasetReady.get()) {
+        telemetry().stop();
+        autolykos2_engine_destroy(engine);
+        return 1;
+    }
+    if (autotune) {
+        std::cout << "[AUTOTUNE] Tuning profile " << profileKey << "\n";
+        EngineProfile tuned = autotune_engine(engine, cfg.value("autotune_trial_s", 2.0));
+        bool saved = save_profile(profileCache, profileKey, tuned);
+        if (saved) std::cout << "[AUTOTUNE] Saved to " << profileCache << "\n";
+        telemetry().stop();
+        autolykos2_engine_destroy(engine);
+        return saved ? 0 : 1;
+    }
+    if (bench) {
+        int rc = run_bench_mode(cfg, engine, engineCfg, tableBuildS, profile.hashrate > 0.0 ? profileKey : "");
+        telemetry().stop();
+        autolykos2_engine_destroy(engine);
+        return rc;
+    }
+
+    // Stratum and mining threads log through the background writer from here on
+    log_start();
+    StratumClient client(poolHost, poolPort, useSSL, fullWorker, pool_password(cfg["pool"]), minerAddress);
+    client.set_engine(engine);
+    client.set_engine_ready(datasetReady);
+    client.set_batch_target_ms(batchMs);
+    client.set_verify_shares(cfg.value("verify_shares", true));
+    client.set_share_queue_size(cfg.value("share_queue_size", 64u));
+    client.set_share_stats(cfg.value("stats_window_s", 600.0), cfg.value("metrics_file", ""));
+
+    // Miners sharing one pool connection or proxy take distinct worker IDs
+    uint32_t workerIdBits = cfg.value("worker_id_bits", 0u);
+    if (!client.set_worker_id(cfg.value("worker_id", 0u), workerIdBits)) {
+        std::cerr << "[MAIN] worker_id does not fit in " << workerIdBits << " worker_id_bits\n";
+        datasetReady.wait();
+        log_stop();
+        telemetry().stop();
+        autolykos2_engine_destroy(engine);
+        return 1;
+    }
+
+    // "share_rate": {"min_per_min", "max_per_min", "window_s"} drives mining.suggest_difficulty
+    if (cfg.contains("share_rate")) {
+        const json& r = cfg["share_rate"];
+        ShareRateConfig rateCfg;
+        rateCfg.min_per_min = r.value("min_per_min", 0.0);
+        rateCfg.max_per_min = r.value("max_per_min", 0.0);
+        rateCfg.window_s = r.value("window_s", 120.0);
+        client.set_share_rate(rateCfg);
+    }
+
+    // "governor": {"mode": "efficiency" | "hashrate", "power_cap_w", "temp_cap_c", "window_s"}
+    std::unique_ptr<EfficiencyGovernor> governor;
+    if (cfg.contains("governor")) {
+        const json& g = cfg["governor"];
+        std::string mode = g.value("mode", "off");
+        GovernorConfig govCfg;
+        govCfg.mode = mode == "efficiency" ? GovernorMode::Efficiency
+                    : mode == "hashrate"   ? GovernorMode::Hashrate
+                    : GovernorMode::Off;
+        govCfg.power_cap_w = g.value("power_cap_w", 0.0);
+        govCfg.temp_cap_c = g.value("temp_cap_c", 0.0);
+        govCfg.window_s = g.value("window_s", 10.0);
+        if (govCfg.mode != GovernorMode::Off) {
+            governor.reset(new EfficiencyGovernor(govCfg, engine, batchMs));
+            client.set_governor(governor.get());
+        }
+    }
+
+    int rc = 0;
+    if (!replayPath.empty()) {
+        rc = run_replay(client, replayPath, replaySpeed);
+    } else {
+        SessionRecorder recorder;
+        std::string recordPath = cfg.value("record_session", "");
+        if (!recordPath.empty() && recorder.open(recordPath)) client.set_recorder(&recorder);
+
+        std::string tracePath = cfg.value("trace_file", "");
+        if (!tracePath.empty()) trace_dump_on_signal(tracePath);
+
+        // Live config changes keep the dataset and workers resident
+        ConfigWatcher watcher("config.json", [&] { reload_config(cfg, client, profile); });
+        watcher.start();
+        client.run();
+        watcher.stop();
+        if (!tracePath.empty()) trace_dump(tracePath);
+        if (!datasetReady.get()) rc = 1;
+    }
+
+    datasetReady.wait();  // stop() may come before the build finishes
+    log_stop();
+    telemetry().stop();
+    autolykos2_engine_destroy(engine);
+    return rc;
 }
@@ -0,0 +1,50 @@
+// nonce_space.cpp
+#include "nonce_space.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+
+static uint64_t low_mask(uint32_t bits) {
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+uint64_t NonceSpace::first() const {
+    uint32_t cb = counter_bits();
+    return prefix | (cb >= 64 ? 0 : (uint64_t)worker_id << cb);
+}
+
+uint64_t NonceSpace::last() const {
+    return first() | low_mask(counter_bits());
+}
+
+bool NonceSpace::contains(uint64_t nonce) const {
+    return (nonce & ~low_mask(counter_bits())) == first();
+}
+
+bool nonce_space_set_extranonce(NonceSpace& space, const std::string& extranonce1_hex, int extranonce2_size) {
+    if (extranonce1_hex.size() % 2 != 0 || extranonce1_hex.size() > 16) return false;
+    for (char c : extranonce1_hex) {
+        if (!isxdigit((unsigned char)c)) return false;
+    }
+    uint32_t prefix_bits = (uint32_t)extranonce1_hex.size() * 4;
+    uint32_t free_bits = 64 - prefix_bits;
+    if (extranonce2_size < 0) return false;
+    uint32_t field_bits = extranonce2_size == 0 ? free_bits
+                                                : std::min<uint32_t>(free_bits, 8u * (uint32_t)extranonce2_size);
+    if (field_bits <= space.worker_bits) return false;
+
+    uint64_t prefix = 0;
+    for (uint8_t b : hex_to_bytes(extranonce1_hex)) prefix = (prefix << 8) | b;
+    space.prefix = prefix_bits == 0 ? 0 : prefix << free_bits;
+    space.prefix_bits = prefix_bits;
+    space.field_bits = field_bits;
+    return true;
+}
+
+bool nonce_space_set_worker(NonceSpace& space, uint32_t worker_id, uint32_t worker_bits) {
+    if (worker_bits >= space.field_bits) return false;
+    if (worker_id > low_mask(worker_bits)) return false;
+    space.worker_bits = worker_bits;
+    space.worker_id = worker_id;
+    return true;
+}
@@ -0,0 +1,47 @@
+// nonce_space.h
+//
+// The 64-bit Autolykos nonce is submitted as 16 big-endian hex digits, and
+// Stratum pools assign each connection the leading bytes of that string
+// (extranonce1), i.e. the most significant bits of the integer. Hashing
+// takes header || nonce with the nonce little-endian, which does not
+// affect the layout. A NonceSpace lays the nonce out as
+//
+//   [ extranonce1 | zero padding | worker ID | counter ]
+//     most significant                  least significant
+//
+// where worker ID and counter together fill the extranonce2 field. Workers
+// with distinct IDs under the same extranonce1 therefore scan disjoint
+// ranges without sharing any state. Engine threads split a batch into
+// contiguous sub-ranges, so they never overlap either.
+#ifndef NONCE_SPACE_H
+#define NONCE_SPACE_H
+
+#include <cstdint>
+#include <string>
+
+struct NonceSpace {
+    uint64_t prefix = 0;        // extranonce1, shifted into the top bytes
+    uint32_t prefix_bits = 0;
+    uint32_t field_bits = 64;   // extranonce2 width: worker ID plus counter
+    uint32_t worker_bits = 0;
+    uint32_t worker_id = 0;
+
+    uint32_t counter_bits() const { return field_bits - worker_bits; }
+
+    // First and last (inclusive) nonce of this worker's range
+    uint64_t first() const;
+    uint64_t last() const;
+    bool contains(uint64_t nonce) const;
+};
+
+// Applies a pool's extranonce1 (hex, at most 8 bytes) and extranonce2 size
+// in bytes; 0 leaves the miner every byte after extranonce1. The worker ID
+// is kept. Returns false and leaves space unchanged on malformed input.
+bool nonce_space_set_extranonce(NonceSpace& space, const std::string& extranonce1_hex, int extranonce2_size);
+
+// Reserves the top worker_bits of extranonce2 for worker_id. Returns false
+// and leaves space unchanged if the ID does not fit or no counter bits would
+// remain.
+bool nonce_space_set_worker(NonceSpace& space, uint32_t worker_id, uint32_t worker_bits);
+
+#endif // NONCE_SPACE_H
@@ -0,0 +1,439 @@
+// selftest.cpp
+#include "selftest.h"
+#include "autolykos2_cpu_miner.h"
+#include "autolykos2_cpu_pipeline.h"
+#include "autolykos2_cpu_stages.h"
+#include "autolykos2_engine.h"
+#include "autolykos2_verifier.h"
+#include "dag_generator.h"
+#include "utils.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+typedef std::array<uint8_t, 32> Hash;
+
+// Every interleave depth fills at least one group, plus a tail for the
+// one-nonce path
+const uint32_t kRangeNonces = AUTOLYKOS2_CPU_MAX_INTERLEAVE + 3;
+
+// Mismatches printed per engine; the rest are only counted
+const uint64_t kMismatchesShown = 5;
+
+// The seed the miner builds its dataset from
+const uint8_t kDatasetSeed[32] = {0};
+
+struct NonceRange {
+    uint8_t header[AUTOLYKOS2_HEADER_SIZE];
+    uint64_t begin;
+};
+
+// One hashing path under test. CPU variants share one engine and are told
+// apart by their tuning.
+struct Subject {
+    std::string name;
+    autolykos2_engine* engine = nullptr;
+    autolykos2_verifier* verifier = nullptr;
+    uint32_t table_bits = 0;
+    std::string isa;
+    uint32_t lanes = 0;
+    uint64_t probes = 0;
+    uint64_t mismatches = 0;
+    std::string first_mismatch;
+    double hashrate = 0.0;
+    bool failed = false;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+std::string hex(const uint8_t* data, size_t len) {
+    return bytes_to_hex(data, len);
+}
+
+// t + 1 as a 256-bit little-endian integer; false if t is the maximum
+bool increment(Hash& t) {
+    for (uint8_t& b : t) {
+        if (++b != 0) return true;
+    }
+    return false;
+}
+
+void mismatch(Subject& s, const std::string& what) {
+    if (s.mismatches++ < kMismatchesShown) printf("[SELFTEST] %s: %s\n", s.name.c_str(), what.c_str());
+    if (s.first_mismatch.empty()) s.first_mismatch = what;
+}
+
+// Tunes the shared CPU engine to the subject's pipeline. Checks run on one
+// worker: split over all of them, a range would be too short to fill the
+// deeper groups.
+bool select(Subject& s, int threads) {
+    if (!s.engine || s.isa.empty()) return true;
+    autolykos2_engine_tuning tuning = {threads, s.lanes, s.isa.c_str()};
+    return autolykos2_engine_tune(s.engine, &tuning);
+}
+
+// Mines [begin, begin + count) below target and checks the answer against
+// the reference hashes of the range: a hit must be a nonce of the range
+// that meets the target, reported with its reference hash, and there must
+// be one exactly when expect_hit.
+void probe(Subject& s, const uint8_t* header, uint64_t begin, const std::vector<Hash>& ref,
+           const Hash& target, bool expect_hit) {
+    uint64_t found_nonce = 0;
+    uint8_t found_hash[32];
+    bool found = false;
+    s.probes++;
+    if (!autolykos2_engine_mine(s.engine, header, begin, (uint32_t)ref.size(), target.data(),
+                                &found_nonce, found_hash, &found)) {
+        mismatch(s, "engine call failed");
+        s.failed = true;
+        return;
+    }
+    std::ostringstream what;
+    what << "range " << begin << "+" << ref.size() << ", target " << hex(target.data(), 32) << ": ";
+    if (!found) {
+        if (expect_hit) mismatch(s, what.str() + "no hit");
+        return;
+    }
+    if (found_nonce < begin || found_nonce - begin >= ref.size()) {
+        what << "hit " << found_nonce << " outside the range";
+        mismatch(s, what.str());
+        return;
+    }
+    const Hash& want = ref[found_nonce - begin];
+    if (memcmp(found_hash, want.data(), 32) != 0) {
+        what << "nonce " << found_nonce << " hashed to " << hex(found_hash, 32) << ", reference " << hex(want.data(), 32);
+        mismatch(s, what.str());
+    } else if (!expect_hit || !meets_target(want.data(), target.data())) {
+        what << "nonce " << found_nonce << " does not meet the target";
+        mismatch(s, what.str());
+    }
+}
+
+void check_range(Subject& s, const NonceRange& range, const std::vector<Hash>& ref) {
+    if (s.verifier) {
+        std::vector<uint64_t> nonces(ref.size());
+        for (size_t i = 0; i < ref.size(); ++i) nonces[i] = range.begin + i;
+        std::vector<uint8_t> hashes(ref.size() * 32);
+        const Hash never = {};
+        autolykos2_verifier_verify_batch(s.verifier, range.header, nonces.data(), (uint32_t)nonces.size(),
+                                         never.data(), hashes.data(), nullptr);
+        for (size_t i = 0; i < ref.size(); ++i) {
+            s.probes++;
+            if (memcmp(hashes.data() + 32 * i, ref[i].data(), 32) != 0) {
+                mismatch(s, "nonce " + std::to_string(nonces[i]) + " hashed to " + hex(hashes.data() + 32 * i, 32) +
+                            ", reference " + hex(ref[i].data(), 32));
+            }
+        }
+        return;
+    }
+
+    // Each nonce's hash + 1 as the target puts that nonce, and every one
+    // hashing lower, in the hit set; the lowest hash as the target must
+    // find nothing
+    for (const Hash& h : ref) {
+        Hash target = h;
+        if (increment(target)) probe(s, range.header, range.begin, ref, target, true);
+        if (s.failed) return;
+    }
+    probe(s, range.header, range.begin, ref, *std::min_element(ref.begin(), ref.end(),
+        [](const Hash& a, const Hash& b) { return meets_target(a.data(), b.data()); }), false);
+}
+
+// Reference hashes of a range, from elements derived on demand
+std::vector<Hash> reference(uint32_t table_bits, const NonceRange& range) {
+    std::vector<Hash> ref(kRangeNonces);
+    for (uint32_t i = 0; i < kRangeNonces; ++i)
+        autolykos2_cpu_hash_ondemand(kDatasetSeed, table_bits, range.header, range.begin + i, ref[i].data());
+    return ref;
+}
+
+std::vector<NonceRange> make_ranges(uint32_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<NonceRange> ranges(std::max<uint32_t>(count, 3));
+    for (size_t r = 0; r < ranges.size(); ++r) {
+        for (size_t i = 0; i < AUTOLYKOS2_HEADER_SIZE; ++i) ranges[r].header[i] = (uint8_t)rng();
+        ranges[r].begin = rng() % (UINT64_MAX - kRangeNonces);
+    }
+    // Edges of nonce space: the start, a carry into the high word, the end
+    memset(ranges[0].header, 0, AUTOLYKOS2_HEADER_SIZE);
+    ranges[0].begin = 0;
+    ranges[1].begin = (1ull << 32) - kRangeNonces / 2;
+    ranges[2].begin = UINT64_MAX - kRangeNonces;
+    return ranges;
+}
+
+// Known answers from the corpus. Engines built on the same seed and table
+// size mine each vector's nonce alone, with its hash + 1 as the target and
+// then with the hash itself, which must miss.
+json check_kat(const SelftestConfig& config, std::vector<Subject>& subjects, bool& passed) {
+    json result = {{"file", config.kat_file}, {"hashes", 0}, {"elements", 0}, {"table_sizes", 0}, {"failures", 0}};
+    std::ifstream in(config.kat_file);
+    if (!in) {
+        printf("[SELFTEST] Cannot read %s\n", config.kat_file.c_str());
+        result["failures"] = 1;
+        passed = false;
+        return result;
+    }
+    json kat;
+    try {
+        kat = json::parse(in);
+    } catch (const std::exception& e) {
+        printf("[SELFTEST] Bad corpus %s: %s\n", config.kat_file.c_str(), e.what());
+        result["failures"] = 1;
+        passed = false;
+        return result;
+    }
+
+    uint64_t failures = 0;
+    auto fail = [&](const std::string& what) {
+        if (failures++ < kMismatchesShown) printf("[SELFTEST] KAT: %s\n", what.c_str());
+    };
+
+    struct EngineVector {
+        std::vector<uint8_t> header;
+        uint64_t nonce;
+        uint32_t table_bits;
+        Hash hash;
+        std::string id;
+    };
+    std::vector<EngineVector> engine_vectors;
+    for (const json& v : kat.value("hashes", json::array())) {
+        std::vector<uint8_t> seed = hex_to_bytes(v["seed"]);
+        std::vector<uint8_t> header = hex_to_bytes(v["header"]);
+        std::vector<uint8_t> want = hex_to_bytes(v["hash"]);
+        uint32_t bits = v["table_bits"];
+        uint64_t nonce = std::stoull(v["nonce"].get<std::string>(), nullptr, 16);
+        if (seed.size() != 32 || header.size() != AUTOLYKOS2_HEADER_SIZE || want.size() != 32) {
+            fail("malformed vector " + v.dump());
+            continue;
+        }
+        std::string id = v["nonce"].get<std::string>() + " on 2^" + std::to_string(bits);
+
+        uint8_t hash1[32];
+        uint32_t r[NUM_SIZE_32];
+        uint32_t ind[K_LEN];
+        seed_stage(header.data(), nonce, hash1, r);
+        index_stage<K_LEN>(r, (uint32_t)((1ull << bits) - 1), ind);
+        if (std::vector<uint32_t>(ind, ind + K_LEN) != v["indices"].get<std::vector<uint32_t>>())
+            fail("indices of " + id);
+
+        uint8_t hash[32];
+        autolykos2_cpu_hash_ondemand(seed.data(), bits, header.data(), nonce, hash);
+        if (memcmp(hash, want.data(), 32) != 0) fail("reference hash of " + id + ": " + hex(hash, 32));
+
+        autolykos2_verifier* verifier = autolykos2_verifier_create(seed.data(), bits, AUTOLYKOS2_VERIFIER_DEFAULT_CACHE);
+        if (!autolykos2_verifier_hash(verifier, header.data(), nonce, hash) || memcmp(hash, want.data(), 32) != 0)
+            fail("verifier hash of " + id + ": " + hex(hash, 32));
+        autolykos2_verifier_destroy(verifier);
+
+        if (memcmp(seed.data(), kDatasetSeed, 32) == 0) {
+            EngineVector e{header, nonce, bits, Hash(), id};
+            memcpy(e.hash.data(), want.data(), 32);
+            engine_vectors.push_back(e);
+        }
+    }
+
+    for (Subject& s : subjects) {
+        if (!s.engine || !select(s, 1)) continue;
+        for (const EngineVector& e : engine_vectors) {
+            if (e.table_bits != s.table_bits || s.failed) continue;
+            uint64_t before = s.mismatches;
+            std::vector<Hash> ref(1, e.hash);
+            Hash above = e.hash;
+            if (increment(above)) probe(s, e.header.data(), e.nonce, ref, above, true);
+            probe(s, e.header.data(), e.nonce, ref, e.hash, false);
+            if (s.mismatches != before) fail(s.name + " on " + e.id);
+        }
+    }
+    result["hashes"] = kat.value("hashes", json::array()).size();
+
+    for (const json& v : kat.value("elements", json::array())) {
+        uint8_t element[32];
+        autolykos2_table_element(v["height"], v["index"], element);
+        if (hex(element, 32) != v["element"].get<std::string>())
+            fail("table element " + v["index"].dump() + " at height " + v["height"].dump());
+    }
+    result["elements"] = kat.value("elements", json::array()).size();
+
+    for (const json& v : kat.value("table_sizes", json::array())) {
+        if (autolykos2_table_size(v["height"]) != v["size"].get<uint32_t>())
+            fail("table size at height " + v["height"].dump());
+    }
+    result["table_sizes"] = kat.value("table_sizes", json::array()).size();
+
+    result["failures"] = failures;
+    if (failures) passed = false;
+    printf("[SELFTEST] Known answers: %zu hashes, %zu elements, %zu table sizes, %llu failure(s)\n",
+           (size_t)result["hashes"], (size_t)result["elements"], (size_t)result["table_sizes"],
+           (unsigned long long)failures);
+    return result;
+}
+
+// Hashes through the subject with a target nothing meets until seconds pass
+double measure(Subject& s, double seconds) {
+    const uint8_t header[AUTOLYKOS2_HEADER_SIZE] = {0};
+    const Hash never = {};
+    uint64_t hashes = 0, nonce = 0;
+    uint32_t count = 1u << 10;
+    auto t0 = std::chrono::steady_clock::now();
+    while (seconds_since(t0) < seconds) {
+        if (s.verifier) {
+            std::vector<uint64_t> nonces(count);
+            for (uint32_t i = 0; i < count; ++i) nonces[i] = nonce + i;
+            autolykos2_verifier_verify_batch(s.verifier, header, nonces.data(), count, never.data(), nullptr, nullptr);
+        } else {
+            uint64_t found_nonce;
+            uint8_t found_hash[32];
+            bool found = false;
+            if (!autolykos2_engine_mine(s.engine, header, nonce, count, never.data(), &found_nonce, found_hash, &found))
+                return 0.0;
+        }
+        nonce += count;
+        hashes += count;
+        // Calls of about 50 ms
+        double elapsed = seconds_since(t0);
+        if (elapsed > 0.0) count = (uint32_t)std::clamp(hashes / elapsed * 0.05, 256.0, (double)(1u << 26));
+    }
+    double elapsed = seconds_since(t0);
+    return elapsed > 0.0 ? hashes / elapsed : 0.0;
+}
+
+autolykos2_engine* make_engine(autolykos2_engine_kind kind, int device, int threads, uint32_t table_bits) {
+    autolykos2_engine_config config = {};
+    config.kind = kind;
+    config.device_id = device;
+    config.threads = threads;
+    config.table_bits = table_bits;
+    autolykos2_engine* engine = autolykos2_engine_create(&config);
+    if (engine && !autolykos2_engine_generate_dataset(engine, kDatasetSeed)) {
+        autolykos2_engine_destroy(engine);
+        return nullptr;
+    }
+    return engine;
+}
+
+} // namespace
+
+std::string run_selftest(const SelftestConfig& config, bool& passed) {
+    passed = true;
+    std::vector<Subject> subjects;
+    std::vector<autolykos2_engine*> engines;
+
+    autolykos2_engine* cpu = make_engine(AUTOLYKOS2_ENGINE_CPU, 0, config.threads, config.table_bits);
+    if (!cpu) {
+        printf("[SELFTEST] Cannot create the CPU engine on a 2^%u table\n", config.table_bits);
+        passed = false;
+        return json{{"passed", false}}.dump();
+    }
+    engines.push_back(cpu);
+    std::vector<std::string> isas = {"scalar"};
+    if (autolykos2_pipeline_isa_supported("avx2")) isas.push_back("avx2");
+    for (const std::string& isa : isas) {
+        for (uint32_t lanes = 1; lanes <= AUTOLYKOS2_CPU_MAX_INTERLEAVE; lanes *= 2) {
+            Subject s;
+            s.name = "cpu/" + isa + "/" + std::to_string(lanes);
+            s.engine = cpu;
+            s.table_bits = config.table_bits;
+            s.isa = isa;
+            s.lanes = lanes;
+            subjects.push_back(s);
+        }
+    }
+
+    json skipped = json::array();
+#ifndef CORTEX_NO_CUDA
+    if (config.cuda) {
+        autolykos2_engine* cuda = make_engine(AUTOLYKOS2_ENGINE_CUDA, config.cuda_device, 0, 0);
+        if (cuda) {
+            engines.push_back(cuda);
+            Subject s;
+            s.name = autolykos2_engine_name(cuda);
+            s.engine = cuda;
+            s.table_bits = AUTOLYKOS2_N;
+            subjects.push_back(s);
+        } else {
+            skipped.push_back("cuda:" + std::to_string(config.cuda_device));
+        }
+    }
+#else
+    if (config.cuda) skipped.push_back("cuda (built without CUDA)");
+#endif
+
+    Subject verifier;
+    verifier.name = "verifier";
+    verifier.verifier = autolykos2_verifier_create(kDatasetSeed, config.table_bits, AUTOLYKOS2_VERIFIER_DEFAULT_CACHE);
+    verifier.table_bits = config.table_bits;
+    subjects.push_back(verifier);
+
+    for (const auto& name : skipped) printf("[SELFTEST] Skipping %s\n", name.get<std::string>().c_str());
+
+    json kat = check_kat(config, subjects, passed);
+
+    // Differential over random ranges, reference hashes computed once per
+    // table size, then throughput on the same pipeline
+    std::vector<NonceRange> ranges = make_ranges(config.ranges, config.seed);
+    std::map<uint32_t, std::vector<std::vector<Hash>>> refs;
+    for (Subject& s : subjects) {
+        auto& ref = refs[s.table_bits];
+        if (ref.empty()) {
+            for (const NonceRange& range : ranges) ref.push_back(reference(s.table_bits, range));
+        }
+        if (!select(s, 1)) {
+            mismatch(s, "cannot select the pipeline");
+            continue;
+        }
+        for (size_t r = 0; r < ranges.size() && !s.failed; ++r) check_range(s, ranges[r], ref[r]);
+        if (config.throughput_s > 0.0 && !s.failed && select(s, config.threads))
+            s.hashrate = measure(s, config.throughput_s);
+        printf("[SELFTEST] %-16s %llu probes, %llu mismatch(es), %.0f H/s\n", s.name.c_str(),
+               (unsigned long long)s.probes, (unsigned long long)s.mismatches, s.hashrate);
+    }
+
+    printf("[SELFTEST] %-16s %10s %10s %14s\n", "engine", "probes", "mismatches", "H/s");
+    json results = json::array();
+    for (const Subject& s : subjects) {
+        printf("[SELFTEST] %-16s %10llu %10llu %14.0f\n", s.name.c_str(), (unsigned long long)s.probes,
+               (unsigned long long)s.mismatches, s.hashrate);
+        if (s.mismatches) passed = false;
+        results.push_back({
+            {"engine", s.name},
+            {"table_bits", s.table_bits},
+            {"probes", s.probes},
+            {"mismatches", s.mismatches},
+            {"first_mismatch", s.first_mismatch.empty() ? json() : json(s.first_mismatch)},
+            {"hashrate", s.hashrate}
+        });
+    }
+    printf("[SELFTEST] %s\n", passed ? "PASSED" : "FAILED");
+
+    json out = {
+        {"passed", passed},
+        {"engine_version", AUTOLYKOS2_ENGINE_VERSION},
+        {"compiler", __VERSION__},
+        {"threads", autolykos2_engine_thread_count(cpu)},
+        {"table_bits", config.table_bits},
+        {"ranges", ranges.size()},
+        {"range_nonces", kRangeNonces},
+        {"seed", config.seed},
+        {"kat", kat},
+        {"engines", results},
+        {"skipped", skipped}
+    };
+
+    autolykos2_verifier_destroy(verifier.verifier);
+    for (autolykos2_engine* e : engines) autolykos2_engine_destroy(e);
+    return out.dump();
+}
@@ -0,0 +1,38 @@
+// selftest.h
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#include <cstdint>
+#include <string>
+
+struct SelftestConfig {
+    std::string kat_file = "autolykos2_kat.json";  // Known-answer corpus written by kat_gen.py
+    uint32_t table_bits = 18;      // Dataset size the CPU variants are checked on
+    int threads = 0;               // CPU engine threads, 0 = all hardware threads
+    bool cuda = true;              // Include CUDA device cuda_device when the build has CUDA
+    int cuda_device = 0;
+    uint32_t ranges = 64;          // Random nonce ranges per engine in the differential
+    uint64_t seed = 1;             // Headers and ranges are drawn from this seed
+    double throughput_s = 2.0;     // Timed hashing per engine, 0 = skip
+};
+
+// Checks every hashing path against the scalar reference and returns the
+// results as one line of JSON; passed is false on any mismatch.
+//
+// Known answers: hashes and indices in the corpus are recomputed with the
+// on-demand reference, the stage functions and the table-less verifier,
+// and mined by every engine built on the same seed and table size. Network
+// table elements and table sizes are checked as well.
+//
+// Differential: each CPU ISA and interleave depth, CUDA when present and
+// the verifier hash the same random nonce ranges. Engines only report one
+// hit per call, so every nonce's reference hash plus one is used as the
+// target in turn: the engine must return a nonce whose hash it reproduces
+// bit for bit, and must find nothing below the smallest hash of the range.
+// CPU checks run on one worker so every range fills the deepest groups.
+//
+// Throughput of every engine is measured afterwards on the same dataset,
+// with all configured threads.
+std::string run_selftest(const SelftestConfig& config, bool& passed);
+
+#endif // SELFTEST_H
@@ -0,0 +1,122 @@
+// share_queue.cpp
+#include "share_queue.h"
+#include <algorithm>
+
+ShareQueue::ShareQueue(size_t capacity, std::chrono::seconds answer_timeout)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      answer_timeout_(answer_timeout)
+{
+}
+
+void ShareQueue::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    capacity_ = std::max<size_t>(capacity, 1);
+    while (shares_.size() > capacity_) {
+        shares_.pop_front();
+        stats_.overflow++;
+    }
+    while (answered_.size() > capacity_) answered_.pop_front();
+}
+
+bool ShareQueue::seen(const PendingShare& share) const {
+    auto same = [&](const PendingShare& s) { return s.nonce == share.nonce && s.job_id == share.job_id; };
+    return std::any_of(shares_.begin(), shares_.end(), same) ||
+           std::any_of(in_flight_.begin(), in_flight_.end(), [&](const auto& kv) { return same(kv.second); }) ||
+           std::any_of(answered_.begin(), answered_.end(), same);
+}
+
+bool ShareQueue::push(const PendingShare& share) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (seen(share)) {
+        stats_.duplicate++;
+        return false;
+    }
+    if (shares_.size() >= capacity_) {
+        shares_.pop_front();
+        stats_.overflow++;
+    }
+    shares_.push_back(share);
+    shares_.back().request_id = 0;
+    shares_.back().sends = 0;
+    return true;
+}
+
+std::vector<PendingShare> ShareQueue::take_sendable(const std::vector<std::string>& jobs, const NonceSpace& nonces, uint64_t& stale) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<PendingShare> out;
+    stale = 0;
+
+    // Sent ones stay until answered, whatever job the pool is on now
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+        if (now - it->second.sent_at > answer_timeout_) {
+            stats_.unanswered++;
+            it = in_flight_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = shares_.begin(); it != shares_.end();) {
+        if (std::find(jobs.begin(), jobs.end(), it->job_id) == jobs.end() || !nonces.contains(it->nonce)) {
+            // Sent on an earlier connection, which can no longer answer
+            if (it->sends == 0) {
+                stale++;
+                stats_.stale++;
+            } else {
+                stats_.unanswered++;
+            }
+            it = shares_.erase(it);
+            continue;
+        }
+        it->request_id = next_id_++;
+        it->sent_at = now;
+        if (it->sends++ > 0) stats_.resubmitted++;
+        out.push_back(*it);
+        in_flight_.emplace(it->request_id, *it);
+        it = shares_.erase(it);
+    }
+    return out;
+}
+
+void ShareQueue::send_failed(uint64_t request_id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = in_flight_.find(request_id);
+    if (it == in_flight_.end()) return;
+    PendingShare share = it->second;
+    in_flight_.erase(it);
+    if (--share.sends > 0) stats_.resubmitted--;
+    share.request_id = 0;
+    shares_.push_front(share);
+}
+
+bool ShareQueue::answer(uint64_t request_id, bool accepted, PendingShare& share) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = in_flight_.find(request_id);
+    if (it == in_flight_.end()) return false;
+    share = it->second;
+    in_flight_.erase(it);
+    answered_.push_back(share);
+    if (answered_.size() > capacity_) answered_.pop_front();
+    accepted ? stats_.accepted++ : stats_.rejected++;
+    return true;
+}
+
+void ShareQueue::connection_lost() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& kv : in_flight_) {
+        kv.second.request_id = 0;
+        shares_.push_back(kv.second);
+    }
+    in_flight_.clear();
+}
+
+size_t ShareQueue::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return shares_.size() + in_flight_.size();
+}
+
+ShareQueueStats ShareQueue::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
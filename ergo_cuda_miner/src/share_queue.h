@@ -0,0 +1,96 @@
+// share_queue.h
+#ifndef SHARE_QUEUE_H
+#define SHARE_QUEUE_H
+
+#include "nonce_space.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct PendingShare {
+    std::string job_id;
+    uint64_t nonce = 0;
+    std::string nonce_hex;    // Big-endian, as submitted
+    std::string pow_hash;
+    double difficulty = 0.0;  // Share difficulty it was found at
+    uint64_t request_id = 0;  // mining.submit ID on the current connection, 0 = not sent on it
+    uint32_t sends = 0;
+    std::chrono::steady_clock::time_point sent_at;  // Last send on the current connection
+};
+
+struct ShareQueueStats {
+    uint64_t resubmitted = 0;  // Sends after the first, e.g. on a new connection
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+    uint64_t stale = 0;        // Dropped never sent: the pool moved to another job first
+    uint64_t unanswered = 0;   // Sent but never answered: timed out, or the connection closed after the job was replaced
+    uint64_t overflow = 0;     // Oldest shares evicted to stay within capacity
+    uint64_t duplicate = 0;    // Found again while queued or after an answer
+};
+
+// Verified shares from the moment they are found until the pool answers
+// them. A share goes out whenever its job is the pool's current one and a
+// connection is up; when the connection drops before an answer arrives it
+// is held and sent again on the next connection, as long as the pool is
+// still on that job and the nonce lies in the new connection's range. A
+// share the pool did receive may come back as a duplicate, which costs
+// less than losing one. Unsent shares of any other job are stale and
+// dropped. Sent ones wait for their answer by request ID even after the
+// pool moves on, since pools often answer after the next notify, until
+// answer_timeout passes or the connection closes. A new connection mines
+// its job's range from the start again, so shares already queued or
+// answered are recognised and not sent twice.
+// Shared by the mining and listener threads.
+class ShareQueue {
+public:
+    // mining.submit IDs start here, clear of the fixed handshake IDs
+    static const uint64_t kFirstRequestId = 100;
+
+    explicit ShareQueue(size_t capacity = 64,
+                        std::chrono::seconds answer_timeout = std::chrono::seconds(120));
+
+    void set_capacity(size_t capacity);
+
+    // Queues a share for sending, evicting the oldest when full. Returns
+    // false for a share seen before.
+    bool push(const PendingShare& share);
+
+    // Unsent shares of any of jobs inside nonces, each marked sent under a
+    // fresh request ID. Unsent shares of other jobs, and sent ones past the
+    // answer timeout, are dropped. stale receives how many were never sent.
+    std::vector<PendingShare> take_sendable(const std::vector<std::string>& jobs, const NonceSpace& nonces, uint64_t& stale);
+
+    // The send carrying request_id did not go out; it is retried next time
+    // as if never taken
+    void send_failed(uint64_t request_id);
+
+    // Pool answer to request_id. Returns false if it is not one of ours;
+    // otherwise share holds the answered share, now removed.
+    bool answer(uint64_t request_id, bool accepted, PendingShare& share);
+
+    // The connection closed: every unanswered share is sent again on the
+    // next one if its job is still current, otherwise counted unanswered
+    void connection_lost();
+
+    size_t size() const;
+    ShareQueueStats stats() const;
+
+private:
+    bool seen(const PendingShare& share) const;
+
+    mutable std::mutex mtx_;
+    std::deque<PendingShare> shares_;  // Not sent on this connection, oldest first
+    std::map<uint64_t, PendingShare> in_flight_;  // Sent on this connection, by request ID
+    std::deque<PendingShare> answered_;  // Most recent answers, up to capacity
+    size_t capacity_;
+    std::chrono::seconds answer_timeout_;
+    uint64_t next_id_ = kFirstRequestId;
+    ShareQueueStats stats_;
+};
+
+#endif // SHARE_QUEUE_H
@@ -0,0 +1,68 @@
+// share_rate.cpp
+#include "share_rate.h"
+#include <algorithm>
+#include <cmath>
+
+ShareRateController::ShareRateController(const ShareRateConfig& config)
+    : config_(config)
+{
+    if (config_.window_s <= 0.0) config_.window_s = 120.0;
+    if (config_.min_per_min > 0.0 && config_.max_per_min > 0.0 && config_.max_per_min < config_.min_per_min) {
+        std::swap(config_.min_per_min, config_.max_per_min);
+    }
+    start_window();
+}
+
+void ShareRateController::start_window() {
+    shares_ = 0;
+    window_start_ = std::chrono::steady_clock::now();
+}
+
+void ShareRateController::on_share() {
+    shares_++;
+}
+
+void ShareRateController::on_difficulty(double difficulty) {
+    if (difficulty == difficulty_) return;
+    difficulty_ = difficulty;
+    start_window();
+}
+
+bool ShareRateController::poll(double hashrate, double& suggest, double& rate_per_min) {
+    if (!enabled() || difficulty_ <= 0.0) return false;
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - window_start_).count();
+    if (s < config_.window_s) return false;
+
+    double rate = shares_ * 60.0 / s;
+    bool low = config_.min_per_min > 0.0 && rate < config_.min_per_min;
+    bool high = config_.max_per_min > 0.0 && rate > config_.max_per_min;
+    if (!low && !high) {
+        start_window();
+        return false;
+    }
+
+    double want;
+    if (config_.min_per_min > 0.0 && config_.max_per_min > 0.0) {
+        want = std::sqrt(config_.min_per_min * config_.max_per_min);
+    } else if (config_.min_per_min > 0.0) {
+        want = 2.0 * config_.min_per_min;
+    } else {
+        want = 0.5 * config_.max_per_min;
+    }
+
+    double predicted = hashrate * 60.0 / want;
+    if (shares_ == 0) {
+        if (hashrate <= 0.0) {
+            start_window();
+            return false;
+        }
+        suggest = predicted;
+    } else {
+        suggest = difficulty_ * rate / want;
+        if (high) suggest = std::max(suggest, predicted);
+    }
+    suggest = std::max(suggest, 1.0);
+    rate_per_min = rate;
+    start_window();
+    return true;
+}
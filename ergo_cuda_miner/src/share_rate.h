@@ -0,0 +1,49 @@
+// share_rate.h
+#ifndef SHARE_RATE_H
+#define SHARE_RATE_H
+
+#include <chrono>
+#include <cstdint>
+
+struct ShareRateConfig {
+    double min_per_min = 0.0;  // 0 = no lower bound
+    double max_per_min = 0.0;  // 0 = no upper bound
+    double window_s = 120.0;   // Shortest measurement before acting
+};
+
+// Keeps our submission rate inside [min_per_min, max_per_min] by suggesting
+// a pool difficulty. A share is a hash below 2^256 / difficulty, so at H
+// hashes per second shares arrive at H / difficulty per second. Each window
+// counts the shares actually found; when the rate falls outside the band,
+// the suggestion rescales the current difficulty to the middle of the band.
+// Engines report at most one share per batch, which caps the measured rate,
+// so above the band the hashrate estimate is used when it is higher; a
+// window without a single share relies on it entirely. Driven from the
+// mining thread only.
+class ShareRateController {
+public:
+    explicit ShareRateController(const ShareRateConfig& config);
+
+    bool enabled() const { return config_.min_per_min > 0.0 || config_.max_per_min > 0.0; }
+
+    // A share was found (after verification)
+    void on_share();
+
+    // The pool changed difficulty: measurements so far no longer apply
+    void on_difficulty(double difficulty);
+
+    // Called periodically with the engine hashrate. Returns true with the
+    // difficulty to suggest and the measured shares per minute when the
+    // window ends outside the band.
+    bool poll(double hashrate, double& suggest, double& rate_per_min);
+
+private:
+    void start_window();
+
+    ShareRateConfig config_;
+    double difficulty_ = 0.0;  // Last difficulty set by the pool, 0 = unknown
+    uint64_t shares_ = 0;
+    std::chrono::steady_clock::time_point window_start_;
+};
+
+#endif // SHARE_RATE_H
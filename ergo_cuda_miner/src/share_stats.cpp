@@ -0,0 +1,196 @@
+// share_stats.cpp
+#include "share_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+static const int kBuckets = 60;
+
+static void add(ShareCounts& a, const ShareCounts& b) {
+    a.hashes += b.hashes;
+    a.expected += b.expected;
+    a.found += b.found;
+    a.accepted += b.accepted;
+    a.rejected += b.rejected;
+    a.stale += b.stale;
+    a.accepted_difficulty += b.accepted_difficulty;
+}
+
+// 95% interval for the mean of a Poisson variable observed as k
+// (Wilson-Hilferty approximation of the exact chi-square bounds)
+static void poisson_interval(uint64_t k, double& low, double& high) {
+    const double z = 1.96;
+    if (k == 0) {
+        low = 0.0;
+    } else {
+        double n = (double)k;
+        low = n * std::pow(1.0 - 1.0 / (9.0 * n) - z / (3.0 * std::sqrt(n)), 3);
+    }
+    double n1 = (double)k + 1.0;
+    high = n1 * std::pow(1.0 - 1.0 / (9.0 * n1) + z / (3.0 * std::sqrt(n1)), 3);
+}
+
+static json counts_json(const ShareCounts& c) {
+    return {
+        {"hashes", c.hashes},
+        {"expected", c.expected},
+        {"found", c.found},
+        {"accepted", c.accepted},
+        {"rejected", c.rejected},
+        {"stale", c.stale},
+        {"accepted_difficulty", c.accepted_difficulty}
+    };
+}
+
+ShareStats::ShareStats(double window_s)
+    : bucket_s_((window_s > 0.0 ? window_s : 600.0) / kBuckets),
+      start_(std::chrono::steady_clock::now()),
+      window_start_(start_)
+{
+    set_source("", "");
+}
+
+void ShareStats::set_window(double window_s) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    double bucket_s = (window_s > 0.0 ? window_s : 600.0) / kBuckets;
+    if (bucket_s == bucket_s_) return;
+    bucket_s_ = bucket_s;
+    window_start_ = std::chrono::steady_clock::now();
+    for (auto& kv : sources_) {
+        kv.second.buckets.assign(kBuckets, ShareCounts());
+        kv.second.bucket_ids.assign(kBuckets, -1);
+    }
+}
+
+int64_t ShareStats::bucket_id() const {
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    return (int64_t)(s / bucket_s_);
+}
+
+void ShareStats::set_source(const std::string& pool, const std::string& engine) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Source& s = sources_[pool + "/" + engine];
+    if (s.buckets.empty()) {
+        s.pool = pool;
+        s.engine = engine;
+        s.buckets.resize(kBuckets);
+        s.bucket_ids.assign(kBuckets, -1);
+    }
+    current_ = &s;
+}
+
+ShareCounts& ShareStats::bucket(Source& s) {
+    int64_t id = bucket_id();
+    int slot = (int)(id % kBuckets);
+    if (s.bucket_ids[slot] != id) {
+        s.buckets[slot] = ShareCounts();
+        s.bucket_ids[slot] = id;
+    }
+    return s.buckets[slot];
+}
+
+void ShareStats::on_hashes(uint64_t hashes, double difficulty) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ShareCounts c;
+    c.hashes = (double)hashes;
+    // The batch reports a share if it holds at least one
+    c.expected = difficulty > 0.0 ? -std::expm1(-(double)hashes / difficulty) : 0.0;
+    add(current_->total, c);
+    add(bucket(*current_), c);
+}
+
+void ShareStats::on_found() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    current_->total.found++;
+    bucket(*current_).found++;
+}
+
+void ShareStats::on_stale(uint64_t shares) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    current_->total.stale += shares;
+    bucket(*current_).stale += shares;
+}
+
+void ShareStats::on_answer(bool accepted, double difficulty) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ShareCounts c;
+    if (accepted) {
+        c.accepted = 1;
+        c.accepted_difficulty = difficulty;
+    } else {
+        c.rejected = 1;
+    }
+    add(current_->total, c);
+    add(bucket(*current_), c);
+}
+
+ShareStatsReport ShareStats::summarize(Source& s, int64_t now_id) {
+    ShareStatsReport r;
+    r.pool = s.pool;
+    r.engine = s.engine;
+    r.total = s.total;
+    for (int i = 0; i < kBuckets; ++i) {
+        if (s.bucket_ids[i] >= 0 && s.bucket_ids[i] > now_id - kBuckets) add(r.window, s.buckets[i]);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - window_start_).count();
+    r.window_s = std::min(elapsed, bucket_s_ * kBuckets);
+    if (r.window_s > 0.0) {
+        r.local_hashrate = r.window.hashes / r.window_s;
+        r.effective_hashrate = r.window.accepted_difficulty / r.window_s;
+    }
+    if (r.window.expected > 0.0) {
+        double low, high;
+        poisson_interval(r.window.found, low, high);
+        r.luck = r.window.found / r.window.expected;
+        r.luck_low = low / r.window.expected;
+        r.luck_high = high / r.window.expected;
+    }
+    uint64_t answered = r.window.accepted + r.window.rejected;
+    if (answered) r.reject_ratio = (double)r.window.rejected / answered;
+    if (r.window.found) r.stale_ratio = (double)r.window.stale / r.window.found;
+    return r;
+}
+
+std::vector<ShareStatsReport> ShareStats::report() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    int64_t now_id = bucket_id();
+    std::vector<ShareStatsReport> out;
+    out.push_back(summarize(*current_, now_id));
+    for (auto& kv : sources_) {
+        if (&kv.second == current_) continue;
+        if (kv.second.total.hashes == 0.0 && kv.second.total.found == 0) continue;
+        out.push_back(summarize(kv.second, now_id));
+    }
+    return out;
+}
+
+bool ShareStats::write_json(const std::string& path) {
+    json sources = json::array();
+    for (const ShareStatsReport& r : report()) {
+        sources.push_back({
+            {"pool", r.pool},
+            {"engine", r.engine},
+            {"window_s", r.window_s},
+            {"local_hashrate", r.local_hashrate},
+            {"effective_hashrate", r.effective_hashrate},
+            {"luck", r.luck},
+            {"luck_low", r.luck_low},
+            {"luck_high", r.luck_high},
+            {"reject_ratio", r.reject_ratio},
+            {"stale_ratio", r.stale_ratio},
+            {"window", counts_json(r.window)},
+            {"total", counts_json(r.total)}
+        });
+    }
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        f << json{{"sources", sources}}.dump(2) << "\n";
+        if (!f) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,92 @@
+// share_stats.h
+#ifndef SHARE_STATS_H
+#define SHARE_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Share accounting for one pool and engine pair
+struct ShareCounts {
+    double hashes = 0.0;
+    double expected = 0.0;             // Shares a fair engine reports: at most one per batch
+    uint64_t found = 0;                // Verified shares queued for submission
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+    uint64_t stale = 0;                // Found, but the job was replaced before they went out
+    double accepted_difficulty = 0.0;  // Sum of the difficulty of accepted shares
+};
+
+struct ShareStatsReport {
+    std::string pool;
+    std::string engine;
+    double window_s = 0.0;        // Span the window figures cover
+    ShareCounts window;
+    ShareCounts total;
+    double local_hashrate = 0.0;  // Hashes the engine reported over the window
+    double effective_hashrate = 0.0;  // Accepted difficulty over the window: what the pool credits
+    double luck = 0.0;            // Found / expected over the window, 0 when nothing expected
+    double luck_low = 0.0;        // 95% interval for luck from the Poisson count of found shares
+    double luck_high = 0.0;
+    double reject_ratio = 0.0;    // Rejected / answered
+    double stale_ratio = 0.0;     // Stale / found
+};
+
+// Links local work to what the pool credits. Work is counted in expected
+// shares: at difficulty d every hash has a 1/d chance of being a share.
+// Engines stop a batch at its first hit, so a batch of n hashes reports a
+// share with probability 1 - exp(-n / d) rather than n / d shares; luck
+// is measured against that, and when batches routinely hold several
+// shares the effective hashrate falls short of the local one by the hits
+// the engine never reported. A found count far outside the Poisson
+// interval around that, a high reject ratio, or an effective hashrate well
+// under the local one points at an engine producing bad work or a pool
+// under-crediting. Figures are kept per pool and engine, over a rolling
+// window of window_s (in 60 buckets) and since start. Thread-safe.
+class ShareStats {
+public:
+    explicit ShareStats(double window_s = 600.0);
+
+    // Changes the rolling window; window figures start over
+    void set_window(double window_s);
+
+    // Events from here on are accounted to this pool and engine
+    void set_source(const std::string& pool, const std::string& engine);
+
+    // One engine batch of hashes mined at share difficulty
+    void on_hashes(uint64_t hashes, double difficulty);
+    void on_found();
+    void on_stale(uint64_t shares);
+    void on_answer(bool accepted, double difficulty);
+
+    // Figures for every pool and engine seen, current one first
+    std::vector<ShareStatsReport> report();
+
+    // Writes report() as JSON to path, replacing the file atomically
+    bool write_json(const std::string& path);
+
+private:
+    struct Source {
+        std::string pool;
+        std::string engine;
+        ShareCounts total;
+        std::vector<ShareCounts> buckets;
+        std::vector<int64_t> bucket_ids;  // Which bucket period each slot holds
+    };
+
+    ShareCounts& bucket(Source& s);
+    ShareStatsReport summarize(Source& s, int64_t now_id);
+    int64_t bucket_id() const;
+
+    std::mutex mtx_;
+    double bucket_s_;
+    std::chrono::steady_clock::time_point start_;         // Bucket periods count from here
+    std::chrono::steady_clock::time_point window_start_;  // Last window change
+    std::map<std::string, Source> sources_;
+    Source* current_ = nullptr;
+};
+
+#endif // SHARE_STATS_H
@@ -1,10 +1,19 @@
 #include "stratum_client.h"
-#include "autolykos2_cuda_miner.h"
+#include "governor.h"
+#include "logger.h"
+#include "stratum_session.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <cstring>
 #include <netdb.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <thread>
 #include <vector>
@@ -12,6 +21,10 @@
 
 using json = nlohmann::json;
 
+// Earlier jobs kept open by notifies without clean_jobs; older ones are
+// assumed closed by the pool
+static const size_t kMaxLiveJobs = 8;
+
 StratumClient::StratumClient(const std::string& host,
                              int port,
                              bool ssl,
@@ -38,69 +51,133 @@ void StratumClient::run() {
     running_ = true;
     while (running_) {
         if (!connect()) {
-            std::cout << "[ERROR] Could not connect to pool. Retrying in 10 seconds...\n";
+            LOG_ERROR("[ERROR] Could not connect to pool. Retrying in 10 seconds...");
             sleep(10);
             continue;
         }
+        // set_pool during connect() found no socket to shut down
+        if (reconnect_.exchange(false)) {
+            LOG_INFO("[STRATUM] Pool settings changed while connecting, reconnecting...");
+            continue;
+        }
 
-        // Immediately send subscribe and authorize, as done by real miners
-        subscribe();
-        authorize();
-        std::cout << "[DEBUG] Sent subscribe and authorize" << std::endl;
+        run_session();
 
-        listener_ = std::thread(&StratumClient::listen, this);
-        miner_ = std::thread(&StratumClient::mining_thread, this);
+        if (running_ && reconnect_.exchange(false)) {
+            LOG_INFO("[STRATUM] Reconnecting with new pool settings...");
+        } else if (running_) {
+            LOG_WARN("[ERROR] Connection lost. Reconnecting in 10 seconds...");
+            sleep(10);
+        }
+    }
+}
 
-        listener_.join();
-        miner_.join();
+void StratumClient::run_on_socket(int fd) {
+    running_ = true;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        sock_ = fd;
+    }
+    run_session();
+}
 
-        close(sock_);
-        sock_ = -1;
+// One connected session: handshake, then listener and mining threads until
+// the socket closes or stop() is called
+void StratumClient::run_session() {
+    // Work from a previous connection must not leak into this one
+    {
+        std::lock_guard<std::mutex> lock(current_job_.mtx);
+        current_job_.active = false;
+        current_job_.has_difficulty = false;
+        current_job_.live_jobs.clear();
+        nonce_space_set_extranonce(current_job_.nonces, "", 0);
+    }
+    session_up_ = true;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        share_stats_.set_source(host_ + ":" + std::to_string(port_), autolykos2_engine_name(engine_));
+    }
 
-        if (running_) {
-            std::cout << "[ERROR] Connection lost. Reconnecting in 10 seconds...\n";
-            sleep(10);
-        }
+    // Immediately send subscribe and authorize, as done by real miners
+    subscribe();
+    authorize();
+    LOG_DEBUG("[DEBUG] Sent subscribe and authorize");
+
+    listener_ = std::thread(&StratumClient::listen, this);
+    miner_ = std::thread(&StratumClient::mining_thread, this);
+
+    listener_.join();
+    miner_.join();
+
+    close_socket();
+
+    shares_.connection_lost();
+    if (size_t held = shares_.size()) {
+        LOG_WARN("[STRATUM] Holding " << held << " unanswered share(s) for the next connection");
     }
 }
 
+// Closes the session socket. The lock keeps set_pool and stop from
+// reaching a descriptor number the system has already handed out again.
+void StratumClient::close_socket() {
+    std::lock_guard<std::mutex> lock(settings_mtx_);
+    if (sock_ > 0) close(sock_);
+    sock_ = -1;
+}
+
 bool StratumClient::connect() {
-    if (sock_ > 0) {
-        close(sock_);
-        sock_ = -1;
-    }
+    close_socket();
     struct addrinfo hints{}, *res;
     hints.ai_family = AF_INET;
     hints.ai_socktype = SOCK_STREAM;
     char portstr[6];
-    snprintf(portstr, sizeof(portstr), "%d", port_);
-    int err = getaddrinfo(host_.c_str(), portstr, &hints, &res);
+    std::string host;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        host = host_;
+        snprintf(portstr, sizeof(portstr), "%d", port_);
+    }
+    int err = getaddrinfo(host.c_str(), portstr, &hints, &res);
     if (err != 0) {
-        std::cout << "[STRATUM] getaddrinfo error: " << gai_strerror(err) << std::endl;
+        LOG_ERROR("[STRATUM] getaddrinfo error: " << gai_strerror(err));
         return false;
     }
-    sock_ = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (sock_ < 0) {
-        std::cout << "[STRATUM] socket error: " << strerror(errno) << std::endl;
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0) {
+        LOG_ERROR("[STRATUM] socket error: " << strerror(errno));
         freeaddrinfo(res);
         return false;
     }
-    if (::connect(sock_, res->ai_addr, res->ai_addrlen) < 0) {
-        std::cout << "[STRATUM] connect() error: " << strerror(errno) << std::endl;
-        close(sock_);
-        sock_ = -1;
+    if (::connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+        LOG_ERROR("[STRATUM] connect() error: " << strerror(errno));
+        close(fd);
         freeaddrinfo(res);
         return false;
     }
     freeaddrinfo(res);
-    std::cout << "[STRATUM] Connected to pool " << host_ << ":" << port_ << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        sock_ = fd;
+    }
+    LOG_INFO("[STRATUM] Connected to pool " << host << ":" << portstr);
     return true;
 }
 
-void StratumClient::send_json(const json& j) {
+// Returns false if the line did not go out whole
+bool StratumClient::send_json(const json& j) {
     std::string data = j.dump() + "\n";
-    std::cout << "[STRATUM] SENT: " << data;
-    send(sock_, data.c_str(), data.size(), 0);
+    ssize_t sent;
+    {
+        std::lock_guard<std::mutex> lock(send_mtx_);
+        sent = send(sock_, data.c_str(), data.size(), MSG_NOSIGNAL);
+        if (recorder_) recorder_->record('>', data.substr(0, data.size() - 1));
+    }
+    if (sent != (ssize_t)data.size()) {
+        LOG_WARN("[STRATUM] Send failed: " << (sent < 0 ? strerror(errno) : "short write"));
+        return false;
+    }
+    LOG_DEBUG("[STRATUM] SENT: " << data.substr(0, data.size() - 1));
+    return true;
 }
 
 void StratumClient::subscribe() {
@@ -113,6 +190,7 @@ void StratumClient::subscribe() {
 }
 
 void StratumClient::authorize() {
+    std::lock_guard<std::mutex> lock(settings_mtx_);
     std::string fullWorker = worker_;
     // Always build address.worker for pools like WoolyPooly, SigmaNa⁠uts
     if (worker_.find('.') == std::string::npos) {
@@ -127,24 +205,27 @@ void StratumClient::authorize() {
 }
 
 void StratumClient::listen() {
-    std::cout << "[STRATUM] Entered listen()" << std::endl;
+    LOG_DEBUG("[STRATUM] Entered listen()");
+    TRACE_THREAD_NAME("stratum-listener");
     char buffer[4096];
     std::string line;
     while (running_) {
         ssize_t n = recv(sock_, buffer, sizeof(buffer), 0);
         if (n <= 0) {
-            std::cout << "[STRATUM] Socket closed or error." << std::endl;
-            running_ = false;
+            LOG_WARN("[STRATUM] Socket closed or error.");
+            session_up_ = false;
+            current_job_.cv.notify_all();
             break;
         }
         for (ssize_t i = 0; i < n; ++i) {
             if (buffer[i] == '\n') {
-                std::cout << "[STRATUM RAW LINE] " << line << std::endl;
+                LOG_DEBUG("[STRATUM RAW LINE] " << line);
+                if (recorder_) recorder_->record('<', line);
                 try {
                     auto msg = json::parse(line);
                     handle_message(msg);
                 } catch (const std::exception& e) {
-                    std::cerr << "[STRATUM JSON ERROR] " << e.what() << " (input: " << line << ")" << std::endl;
+                    CORTEX_LOG_EVERY_MS(LogLevel::Warn, 1000, "[STRATUM JSON ERROR] " << e.what() << " (input: " << line << ")");
                 }
                 line.clear();
             } else {
@@ -155,18 +236,70 @@ void StratumClient::listen() {
 }
 
 void StratumClient::handle_message(const json& msg) {
-    std::cout << "[STRATUM DEBUG] handle_message called with: " << msg.dump() << std::endl;
+    LOG_TRACE("[STRATUM DEBUG] handle_message called with: " << msg.dump());
+
+    // Subscribe response: [subscriptions, extranonce1, extranonce2_size]
+    if (msg.contains("id") && msg["id"] == 1 && msg.contains("result") && msg["result"].is_array()) {
+        const auto& result = msg["result"];
+        if (result.size() > 1 && result[1].is_string()) {
+            int size = (result.size() > 2 && result[2].is_number_integer()) ? result[2].get<int>() : 0;
+            set_extranonce(result[1].get<std::string>(), size);
+        }
+        return;
+    }
+
+    // Answer to one of our mining.submit requests
+    if (msg.contains("id") && msg["id"].is_number_unsigned() && (msg.contains("result") || msg.contains("error"))) {
+        bool accepted = msg.contains("result") && msg["result"].is_boolean() && msg["result"].get<bool>() &&
+                        (!msg.contains("error") || msg["error"].is_null());
+        PendingShare share;
+        if (shares_.answer(msg["id"].get<uint64_t>(), accepted, share)) {
+            share_stats_.on_answer(accepted, share.difficulty);
+            if (accepted) {
+                LOG_INFO("[STRATUM] Share accepted: nonce=" << share.nonce_hex);
+            } else {
+                LOG_WARN("[STRATUM] Share rejected: nonce=" << share.nonce_hex << ", job_id=" << share.job_id
+                         << ", error=" << (msg.contains("error") ? msg["error"].dump() : "null"));
+            }
+            return;
+        }
+    }
+
+    if (msg.contains("method") && msg["method"] == "mining.set_difficulty") {
+        const auto& params = msg.contains("params") ? msg["params"] : json();
+        if (!params.is_array() || params.empty() || !params[0].is_number() || params[0].get<double>() <= 0.0) {
+            LOG_ERROR("[ERROR] mining.set_difficulty has no usable difficulty!");
+            return;
+        }
+        set_difficulty(params[0].get<double>());
+        return;
+    }
+
+    if (msg.contains("method") && msg["method"] == "mining.set_extranonce") {
+        const auto& params = msg.contains("params") ? msg["params"] : json();
+        if (!params.is_array() || params.empty() || !params[0].is_string()) {
+            LOG_ERROR("[ERROR] mining.set_extranonce has no extranonce1!");
+            return;
+        }
+        int size = (params.size() > 1 && params[1].is_number_integer()) ? params[1].get<int>() : 0;
+        set_extranonce(params[0].get<std::string>(), size);
+        return;
+    }
 
     if (msg.contains("method") && msg["method"] == "mining.notify") {
         if (!msg.contains("params") || !msg["params"].is_array()) {
-            std::cerr << "[ERROR] mining.notify has no params array!" << std::endl;
+            LOG_ERROR("[ERROR] mining.notify has no params array!");
             return;
         }
         const auto& params = msg["params"];
-        std::cout << "[STRATUM DEBUG] notify params: " << params.dump() << std::endl;
+        LOG_DEBUG("[STRATUM DEBUG] notify params: " << params.dump());
 
+        TRACE_SCOPE("notify.parse");
         std::lock_guard<std::mutex> lock(current_job_.mtx);
 
+        std::string prev_job = current_job_.job_id;
+        std::string prev_header = current_job_.header;
+        bool was_active = current_job_.active;
         current_job_.job_id = (params.size() > 0 && params[0].is_string()) ? params[0].get<std::string>() : "";
         // Height: int or string
         if (params.size() > 1 && !params[1].is_null()) {
@@ -183,50 +316,585 @@ void StratumClient::handle_message(const json& msg) {
         }
         current_job_.header = (params.size() > 2 && params[2].is_string()) ? params[2].get<std::string>() : "";
         current_job_.target = (params.size() > 6 && params[6].is_string()) ? params[6].get<std::string>() : "";
+        // Without the flag the pool gets to keep earlier jobs open
+        bool clean_jobs = !(params.size() > 8 && params[8].is_boolean()) || params[8].get<bool>();
 
-        if (current_job_.header.empty() || current_job_.target.empty()) {
-            std::cerr << "[ERROR] Job data malformed: header or target missing." << std::endl;
+        if (current_job_.header.empty() || (current_job_.target.empty() && !current_job_.has_difficulty)) {
+            LOG_ERROR("[ERROR] Job data malformed: header or target missing.");
             current_job_.active = false;
             return;
         }
 
+        // Pool target is a decimal big-endian integer; engines compare little-endian
+        if (!current_job_.has_difficulty) {
+            std::vector<uint8_t> target_be = decimal_to_target_bytes(current_job_.target);
+            std::vector<uint8_t> target_le(target_be.rbegin(), target_be.rend());
+            if (target_le != current_job_.share_target_bytes) {
+                current_job_.share_target_bytes = target_le;
+                current_job_.difficulty = target_bytes_to_difficulty(target_be);
+                current_job_.target_epoch++;
+            }
+        }
+
+        std::vector<std::string>& live = current_job_.live_jobs;
+        if (clean_jobs) live.clear();
+        live.erase(std::remove(live.begin(), live.end(), current_job_.job_id), live.end());
+        live.push_back(current_job_.job_id);
+        if (live.size() > kMaxLiveJobs) live.erase(live.begin(), live.end() - kMaxLiveJobs);
+
+        // A re-notify of the job being mined keeps its batches and nonce offset
+        if (!was_active || current_job_.job_id != prev_job || current_job_.header != prev_header) {
+            current_job_.generation++;
+            current_job_.notified_at = std::chrono::steady_clock::now();
+            TRACE_INSTANT("job.publish", current_job_.generation);
+            LOG_INFO("[STRATUM] New job received: "
+                     << "job_id=" << current_job_.job_id
+                     << ", height=" << current_job_.height
+                     << ", header.length=" << current_job_.header.size()
+                     << ", target.length=" << current_job_.target.size()
+                     << ", clean_jobs=" << (clean_jobs ? "true" : "false"));
+        }
         current_job_.active = true;
         current_job_.cv.notify_all();
 
-        std::stringstream ss;
-        ss << "[STRATUM] New job received: "
-           << "job_id=" << current_job_.job_id
-           << ", height=" << current_job_.height
-           << ", header.length=" << current_job_.header.size()
-           << ", target.length=" << current_job_.target.size();
-        std::cout << ss.str() << std::endl;
+        // Held shares go out if the pool still takes their job; the rest are stale
+        flush_shares(current_job_.live_jobs, current_job_.nonces);
+    }
+}
+
+// Moves this connection's nonce range under a new pool prefix. Batches in
+// flight were drawn from the old range, so this counts as a job switch.
+void StratumClient::set_extranonce(const std::string& extranonce1, int extranonce2_size) {
+    std::lock_guard<std::mutex> lock(current_job_.mtx);
+    NonceSpace next = current_job_.nonces;
+    if (!nonce_space_set_extranonce(next, extranonce1, extranonce2_size)) {
+        LOG_ERROR("[ERROR] Unusable extranonce1=" << extranonce1 << " (extranonce2 size " << extranonce2_size
+                  << ", worker ID bits " << next.worker_bits << "), keeping the current nonce range");
+        return;
+    }
+    current_job_.nonces = next;
+    if (current_job_.active) {
+        current_job_.generation++;
+        current_job_.notified_at = std::chrono::steady_clock::now();
+        current_job_.cv.notify_all();
+    }
+    LOG_INFO("[STRATUM] Extranonce1=" << extranonce1 << ", extranonce2 size " << extranonce2_size
+             << ", nonce range " << std::hex << std::setfill('0') << std::setw(16) << next.first()
+             << "-" << std::setw(16) << next.last());
+}
+
+// Replaces the share target right away. The job itself is unchanged, so
+// work in flight carries on; only candidates are checked against the new
+// target. From now on notify targets are ignored for this connection.
+void StratumClient::set_difficulty(double difficulty) {
+    std::lock_guard<std::mutex> lock(current_job_.mtx);
+    std::vector<uint8_t> target_be = difficulty_to_target_bytes(difficulty);
+    current_job_.share_target_bytes.assign(target_be.rbegin(), target_be.rend());
+    current_job_.difficulty = difficulty;
+    current_job_.has_difficulty = true;
+    current_job_.target_epoch++;
+    LOG_INFO("[STRATUM] Difficulty set to " << difficulty);
+}
+
+void StratumClient::suggest_difficulty(double difficulty, double rate_per_min) {
+    json suggest = {
+        {"id", 5},
+        {"method", "mining.suggest_difficulty"},
+        {"params", {difficulty}}
+    };
+    send_json(suggest);
+    stats_.difficulty_suggestions++;
+    LOG_INFO("[STRATUM] Suggested difficulty " << difficulty << " (share rate "
+             << std::fixed << std::setprecision(2) << rate_per_min << "/min)");
+}
+
+// Copies the current job under the lock. Returns false if no job is active.
+bool StratumClient::refresh_job(JobSnapshot& snap) {
+    std::lock_guard<std::mutex> lock(current_job_.mtx);
+    if (!current_job_.active) return false;
+    if (snap.target_epoch != current_job_.target_epoch) {
+        snap.target_epoch = current_job_.target_epoch;
+        snap.difficulty = current_job_.difficulty;
+        memset(snap.target, 0, sizeof(snap.target));
+        memcpy(snap.target, current_job_.share_target_bytes.data(),
+               std::min(current_job_.share_target_bytes.size(), sizeof(snap.target)));
+    }
+    if (snap.generation == current_job_.generation) return true;
+
+    snap.generation = current_job_.generation;
+    snap.job_id = current_job_.job_id;
+    snap.height = current_job_.height;
+    snap.notified_at = current_job_.notified_at;
+    snap.nonces = current_job_.nonces;
+    std::vector<uint8_t> header = hex_to_bytes(current_job_.header);
+    memset(snap.header, 0, sizeof(snap.header));
+    memcpy(snap.header, header.data(), std::min(header.size(), sizeof(snap.header)));
+    return true;
+}
+
+bool StratumClient::wait_for_job(JobSnapshot& snap) {
+    while (running_ && session_up_) {
+        if (refresh_job(snap)) return true;
+        std::unique_lock<std::mutex> lock(current_job_.mtx);
+        current_job_.cv.wait_for(lock, std::chrono::milliseconds(500), [this] {
+            return current_job_.active.load() || !running_ || !session_up_;
+        });
+    }
+    return false;
+}
+
+// Blocks until the engine can hash. Returns false if the session ends
+// first or the engine failed, in which case the client stops.
+bool StratumClient::wait_for_engine() {
+    if (!engine_ready_.valid()) return true;
+    if (engine_ready_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        LOG_INFO("[MINER] Waiting for the dataset before hashing");
+    }
+    while (running_ && session_up_) {
+        if (engine_ready_.wait_for(std::chrono::milliseconds(200)) != std::future_status::ready) continue;
+        if (engine_ready_.get()) return true;
+        LOG_ERROR("[MINER] Engine " << autolykos2_engine_name(engine_) << " has no dataset, stopping.");
+        stop();
+        return false;
+    }
+    return false;
+}
+
+// Waits for work other than snap's job. Returns false if the session ends first.
+bool StratumClient::wait_for_new_job(JobSnapshot& snap) {
+    uint64_t seen = snap.generation;
+    while (running_ && session_up_) {
+        if (refresh_job(snap) && snap.generation != seen) return true;
+        std::unique_lock<std::mutex> lock(current_job_.mtx);
+        current_job_.cv.wait_for(lock, std::chrono::milliseconds(500), [&] {
+            return current_job_.generation != seen || !running_ || !session_up_;
+        });
+    }
+    return false;
+}
+
+StratumClient::BatchResult StratumClient::run_batch(const JobSnapshot& snap,
+                                                    uint64_t start_nonce,
+                                                    uint32_t nonce_count) {
+    TRACE_SCOPE_ARG("batch.run", nonce_count);
+    BatchResult res;
+    res.generation = snap.generation;
+    res.job_id = snap.job_id;
+    memcpy(res.header, snap.header, sizeof(res.header));
+    res.nonces = snap.nonces;
+    res.start_nonce = start_nonce;
+    res.nonce_count = nonce_count;
+    memcpy(res.target, snap.target, sizeof(res.target));
+    res.difficulty = snap.difficulty;
+    auto t0 = std::chrono::steady_clock::now();
+    res.ok = autolykos2_engine_mine(engine_, snap.header, start_nonce, nonce_count,
+                                    snap.target, &res.nonce, res.hash, &res.found);
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return res;
+}
+
+// Little-endian 256-bit comparison, as the engines do it
+static bool below_target(const uint8_t* hash, const uint8_t* target) {
+    for (int i = 31; i >= 0; --i) {
+        if (hash[i] != target[i]) return hash[i] < target[i];
+    }
+    return false;
+}
+
+// Pre-submit check: the candidate is recomputed with the scalar reference
+// against the share target the batch was mined with. On success hash
+// holds the reference hash, which is what gets submitted.
+bool StratumClient::verify_candidate(const BatchResult& done, uint8_t* hash) {
+    if (!verify_shares_) {
+        memcpy(hash, done.hash, 32);
+        return true;
+    }
+    TRACE_SCOPE("share.verify");
+    bool valid = autolykos2_engine_verify(engine_, done.header, done.nonce, done.target, hash);
+    if (valid && memcmp(hash, done.hash, 32) == 0) return true;
+
+    LOG_ERROR("[MINER] " << (valid ? "Hash mismatch on" : "Dropped invalid")
+              << " candidate from engine " << autolykos2_engine_name(engine_)
+              << ": job_id=" << done.job_id << ", nonce=" << done.nonce
+              << ", batch=" << done.start_nonce << "+" << done.nonce_count
+              << ", engine hash=" << bytes_to_hex(done.hash, 32)
+              << ", reference hash=" << bytes_to_hex(hash, 32));
+    return valid;
+}
+
+// Dashboard-format hardware line. Device readings win; on CPU-only rigs the
+// host package is reported in their place.
+void StratumClient::print_telemetry() {
+    TelemetrySnapshot t = telemetry().snapshot();
+    bool device = t.flags & kTelemetryDeviceTemp;
+    if (!device && !(t.flags & kTelemetryCpuTemp)) return;
+    double temp = device ? t.device_temp_c : t.cpu_temp_c;
+    double power = device ? t.device_power_w : t.cpu_power_w;
+    double util = device ? t.device_util : t.cpu_util;
+    LOG_INFO("[GPU] Temp: " << std::fixed << std::setprecision(1) << temp
+             << "\u00b0C, Power: " << power << "W, Util: " << (int)util << "%");
+}
+
+// Share totals in the dashboard's "Accepted: N | Rejected: M" format, then
+// the window figures of the current pool and engine
+void StratumClient::report_shares() {
+    std::vector<ShareStatsReport> reports = share_stats_.report();
+    const ShareStatsReport& r = reports.front();
+    LOG_INFO("[SHARES] Accepted: " << r.total.accepted << " | Rejected: " << r.total.rejected
+             << " | Stale: " << r.total.stale << " | Effective: " << std::fixed << std::setprecision(2)
+             << r.effective_hashrate << " H/s of " << r.local_hashrate << " H/s | Luck: " << r.luck
+             << " (" << r.luck_low << "-" << r.luck_high << ") over " << std::setprecision(0) << r.window_s << " s");
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        path = metrics_file_;
+    }
+    if (!path.empty() && !share_stats_.write_json(path)) {
+        CORTEX_LOG_EVERY_MS(LogLevel::Warn, 60000, "[SHARES] Cannot write " << path);
     }
 }
 
+// Called as the first batch of a new job is dispatched
+void StratumClient::note_job_switch(const JobSnapshot& snap) {
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - snap.notified_at).count();
+    stats_.job_switches++;
+    stats_.switch_latency_ms_sum += ms;
+    stats_.switch_latency_ms_max = std::max(stats_.switch_latency_ms_max, ms);
+}
+
+// Double-buffered batch driver: batch k+1 is dispatched to the engine before
+// batch k's result is checked and submitted, so the engine never waits on
+// the host between batches. Batch size tracks the engine's measured rate to
+// hold each batch near batch_target_ms_.
 void StratumClient::mining_thread() {
-    // Your mining kernel logic...
+    if (!engine_) {
+        LOG_ERROR("[MINER] No hashing engine configured, mining thread idle.");
+        return;
+    }
+    TRACE_THREAD_NAME("mining");
+    const uint32_t min_batch = 256;
+    const uint32_t max_batch = 1u << 30;
+    uint32_t batch_size = 1u << 16;
+    double rate = 0.0;
+
+    if (!wait_for_engine()) return;
+    JobSnapshot snap;
+    if (!wait_for_job(snap)) return;
+    uint64_t generation = 0;
+    uint64_t offset = 0;  // Nonces of the current job's range already dispatched
+    std::future<BatchResult> inflight;
+
+    // Starts the next batch of snap's nonce range. Returns false, leaving
+    // inflight empty, once the range is used up.
+    auto dispatch = [&]() {
+        if (snap.generation != generation) {
+            generation = snap.generation;
+            offset = 0;
+            note_job_switch(snap);
+            // No batch is running: the engine can switch to this job's table size
+            autolykos2_engine_set_height(engine_, snap.height);
+        }
+        uint64_t room = snap.nonces.last() - snap.nonces.first();  // Range size minus one
+        if (offset > room) return false;
+        uint32_t count = room - offset >= batch_size - 1 ? batch_size : (uint32_t)(room - offset + 1);
+        TRACE_INSTANT("batch.dispatch", count);
+        inflight = std::async(std::launch::async, &StratumClient::run_batch, this, snap,
+                              snap.nonces.first() + offset, count);
+        offset += count;
+        return true;
+    };
+
+    uint64_t hashes = 0;
+    auto report_start = std::chrono::steady_clock::now();
+    dispatch();
+
+    while (running_ && session_up_) {
+        if (!inflight.valid()) {
+            // Range used up: idle until the pool moves to new work
+            if (!wait_for_new_job(snap)) break;
+            dispatch();
+            continue;
+        }
+
+        BatchResult done;
+        {
+            TRACE_SCOPE("batch.wait");
+            done = inflight.get();
+        }
+        TRACE_INSTANT("batch.complete", done.nonce_count);
+
+        // Nothing is in flight: settings from a reload can reach the engine
+        apply_live_tuning();
+
+        // Duty cycling idles the engine in proportion to the batch it just ran
+        if (governor_ && done.ok) {
+            governor_->on_batch(done.nonce_count);
+            batch_target_ms_ = governor_->batch_ms();
+            double duty = governor_->duty();
+            if (duty < 1.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(done.seconds * (1.0 - duty) / duty));
+            }
+        }
+
+        // Pick up a job switch before dispatching the next batch. If the
+        // session is over, done is still checked so its share is kept.
+        bool live = refresh_job(snap) || wait_for_job(snap);
+        if (live && !dispatch()) {
+            CORTEX_LOG_EVERY_MS(LogLevel::Warn, 10000, "[MINER] Nonce range exhausted on job "
+                                << snap.job_id << ", waiting for new work");
+        }
+
+        // Overlapped with the batch just dispatched
+        if (!done.ok) {
+            CORTEX_LOG_EVERY_MS(LogLevel::Error, 1000, "[MINER] Engine " << autolykos2_engine_name(engine_) << " failed a batch.");
+            if (!live) break;
+            continue;
+        }
+        hashes += done.nonce_count;
+        if (done.seconds > 0.0) {
+            double batch_rate = done.nonce_count / done.seconds;
+            rate = (rate == 0.0) ? batch_rate : 0.7 * rate + 0.3 * batch_rate;
+            double want = rate * batch_target_ms_ / 1000.0;
+            batch_size = (uint32_t)std::clamp(want, (double)min_batch, (double)max_batch);
+            batch_size = (batch_size + min_batch - 1) / min_batch * min_batch;
+        }
+
+        share_stats_.on_hashes(done.nonce_count, done.difficulty);
+        if (!batch_live(done)) {
+            stats_.stale_batches++;
+            stats_.stale_nonces += done.nonce_count;
+        }
+        // Queued whatever the job: the share queue drops it if the pool
+        // no longer takes it, and counts it stale then
+        if (done.found) check_candidate(snap, done);
+        if (!live) break;
+
+        share_rate_.on_difficulty(snap.difficulty);
+        double suggest, share_rate;
+        if (share_rate_.poll(rate, suggest, share_rate)) suggest_difficulty(suggest, share_rate);
+
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - report_start).count();
+        if (elapsed >= 10.0) {
+            LOG_INFO("[DEBUG] Hashrate: " << std::fixed << std::setprecision(2) << hashes / elapsed
+                     << " H/s (engine " << autolykos2_engine_name(engine_)
+                     << ", batch " << batch_size << ", stale batches " << stats_.stale_batches
+                     << ", bad candidates " << stats_.bad_candidates
+                     << ", difficulty " << std::setprecision(0) << snap.difficulty << ")");
+            print_telemetry();
+            report_shares();
+            hashes = 0;
+            report_start = now;
+        }
+    }
+    // A share in the last batch is queued for the next connection
+    if (inflight.valid()) {
+        BatchResult done = inflight.get();
+        if (done.ok && done.found) check_candidate(snap, done);
+    }
 }
 
-void StratumClient::submit_share(const std::string& nonce_hex, const std::string& pow_hash) {
-    std::string fullWorker = worker_;
-    if (worker_.find('.') == std::string::npos) {
-        fullWorker = address_ + "." + worker_;
+// True while the pool still takes shares from done's job and nonce range
+bool StratumClient::batch_live(const BatchResult& done) {
+    std::lock_guard<std::mutex> lock(current_job_.mtx);
+    const std::vector<std::string>& live = current_job_.live_jobs;
+    return std::find(live.begin(), live.end(), done.job_id) != live.end() &&
+           current_job_.nonces.contains(done.start_nonce);
+}
+
+// Verifies done's candidate against its own job and queues it for
+// submission. snap is the current job, for the share target now in force.
+void StratumClient::check_candidate(const JobSnapshot& snap, const BatchResult& done) {
+    uint8_t hash[32];
+    if (!done.nonces.contains(done.nonce)) {
+        LOG_ERROR("[MINER] Engine returned nonce " << done.nonce << " outside the assigned range");
+        stats_.bad_candidates++;
+    } else if (!verify_candidate(done, hash)) {
+        stats_.bad_candidates++;
+    } else if (!below_target(hash, snap.target)) {
+        // Difficulty went up while the batch ran
+        stats_.below_target++;
+    } else {
+        uint8_t nonce_be[8];
+        for (int i = 0; i < 8; ++i) nonce_be[i] = (done.nonce >> (56 - 8 * i)) & 0xFF;
+        PendingShare share;
+        share.job_id = done.job_id;
+        share.nonce = done.nonce;
+        share.nonce_hex = bytes_to_hex(nonce_be, 8);
+        share.pow_hash = bytes_to_hex(hash, 32);
+        share.difficulty = done.difficulty;
+        if (!shares_.push(share)) return;  // Already sent on an earlier connection
+        share_stats_.on_found();
+        stats_.shares_submitted++;
+        share_rate_.on_share();
+        // Against the jobs the pool takes now, which may have moved on since done
+        std::lock_guard<std::mutex> lock(current_job_.mtx);
+        flush_shares(current_job_.live_jobs, current_job_.nonces);
+    }
+}
+
+// Sends every queued share that is valid for one of jobs on this connection.
+// Called with current_job_.mtx held and the live jobs, from the mining
+// thread with a new share and from the listener on each notify, so shares
+// held over a reconnect go out with the first job.
+void StratumClient::flush_shares(const std::vector<std::string>& jobs, const NonceSpace& nonces) {
+    if (!session_up_ || jobs.empty()) return;
+    uint64_t stale = 0;
+    std::vector<PendingShare> ready = shares_.take_sendable(jobs, nonces, stale);
+    if (stale) {
+        share_stats_.on_stale(stale);
+        LOG_WARN("[STRATUM] Dropped " << stale << " stale share(s): pool moved to job " << jobs.back());
+    }
+    for (size_t i = 0; i < ready.size(); ++i) {
+        if (!submit_share(ready[i])) {
+            // Neither this share nor the ones after it went out; returned
+            // newest first so the queue keeps its order
+            for (size_t j = ready.size(); j-- > i;) shares_.send_failed(ready[j].request_id);
+            // The connection is broken; wake the listener so the session ends now
+            if (sock_ > 0) shutdown(sock_, SHUT_RDWR);
+            break;
+        }
+    }
+}
+
+bool StratumClient::submit_share(const PendingShare& share) {
+    TRACE_SCOPE("share.submit");
+    std::string fullWorker;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        fullWorker = worker_;
+        if (worker_.find('.') == std::string::npos) {
+            fullWorker = address_ + "." + worker_;
+        }
     }
     json submit = {
-        {"id", 4},
+        {"id", share.request_id},
         {"method", "mining.submit"},
-        {"params", {fullWorker, current_job_.job_id, nonce_hex, pow_hash}}
+        {"params", {fullWorker, share.job_id, share.nonce_hex, share.pow_hash}}
     };
-    send_json(submit);
-    std::cout << "[STRATUM] Submitted share: nonce=" << nonce_hex << std::endl;
+    if (!send_json(submit)) return false;
+    LOG_INFO("[STRATUM] Submitted share: nonce=" << share.nonce_hex << (share.sends > 1 ? " (resubmitted)" : ""));
+    return true;
 }
 
 void StratumClient::stop() {
     running_ = false;
-    if (sock_ > 0) close(sock_);
+    close_socket();
     current_job_.cv.notify_all();
 }
 
 PoolJob& StratumClient::getCurrentJob() {
     return current_job_;
 }
+
+void StratumClient::set_engine(autolykos2_engine* engine) {
+    engine_ = engine;
+}
+
+void StratumClient::set_engine_ready(std::shared_future<bool> ready) {
+    engine_ready_ = ready;
+}
+
+void StratumClient::set_pool(const std::string& host,
+                             int port,
+                             bool ssl,
+                             const std::string& worker,
+                             const std::string& password,
+                             const std::string& address) {
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        host_ = host;
+        port_ = port;
+        ssl_ = ssl;
+        worker_ = worker;
+        password_ = password;
+        address_ = address;
+        // Wakes the listener; run() then reconnects without the usual
+        // back-off. Set first so a connect() in progress sees it too.
+        reconnect_ = true;
+        if (sock_ > 0) shutdown(sock_, SHUT_RDWR);
+    }
+}
+
+bool StratumClient::set_worker_id(uint32_t worker_id, uint32_t worker_bits) {
+    std::lock_guard<std::mutex> lock(current_job_.mtx);
+    return nonce_space_set_worker(current_job_.nonces, worker_id, worker_bits);
+}
+
+void StratumClient::set_share_rate(const ShareRateConfig& config) {
+    share_rate_ = ShareRateController(config);
+}
+
+void StratumClient::set_share_queue_size(size_t size) {
+    shares_.set_capacity(size);
+}
+
+void StratumClient::set_share_stats(double window_s, const std::string& metrics_file) {
+    share_stats_.set_window(window_s);
+    std::lock_guard<std::mutex> lock(settings_mtx_);
+    metrics_file_ = metrics_file;
+}
+
+void StratumClient::set_governor(EfficiencyGovernor* governor) {
+    governor_ = governor;
+}
+
+void StratumClient::set_recorder(SessionRecorder* recorder) {
+    recorder_ = recorder;
+}
+
+const SessionStats& StratumClient::session_stats() const {
+    return stats_;
+}
+
+ShareQueueStats StratumClient::share_queue_stats() const {
+    return shares_.stats();
+}
+
+void StratumClient::set_verify_shares(bool verify) {
+    verify_shares_ = verify;
+}
+
+void StratumClient::set_batch_target_ms(uint32_t ms) {
+    batch_target_ms_ = ms ? ms : 1;
+}
+
+void StratumClient::set_live_tuning(const LiveTuning& tuning) {
+    std::lock_guard<std::mutex> lock(settings_mtx_);
+    if (tuning.retune) {
+        live_tuning_.retune = true;
+        live_tuning_.threads = tuning.threads;
+        live_tuning_.interleave = tuning.interleave;
+        live_tuning_.isa = tuning.isa;
+    }
+    if (tuning.batch_ms) live_tuning_.batch_ms = tuning.batch_ms;
+    live_tuning_pending_ = true;
+}
+
+// Runs on the mining thread between batches, like the governor's own steps,
+// so the engine is never retuned under a running batch. A governor adopts
+// the reloaded settings as its new baseline instead of overwriting them.
+void StratumClient::apply_live_tuning() {
+    LiveTuning tuning;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        if (!live_tuning_pending_) return;
+        tuning = live_tuning_;
+        live_tuning_ = LiveTuning();
+        live_tuning_pending_ = false;
+    }
+    if (tuning.retune) {
+        autolykos2_engine_tuning knobs{};
+        knobs.threads = tuning.threads;
+        knobs.interleave = tuning.interleave;
+        knobs.isa = tuning.isa.empty() ? nullptr : tuning.isa.c_str();
+        if (autolykos2_engine_tune(engine_, &knobs)) {
+            LOG_INFO("[CONFIG] Engine retuned: threads " << tuning.threads << ", interleave " << tuning.interleave);
+        }
+    }
+    if (tuning.batch_ms) set_batch_target_ms(tuning.batch_ms);
+    if (governor_) {
+        governor_->rebase(tuning.retune ? tuning.threads : governor_->threads(), batch_target_ms_);
+    }
+}
@@ -6,8 +6,18 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <future>
+#include <chrono>
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include "autolykos2_engine.h"
+#include "nonce_space.h"
+#include "share_queue.h"
+#include "share_rate.h"
+#include "share_stats.h"
+
+class SessionRecorder;
+class EfficiencyGovernor;
 
 // Mining job info
 struct PoolJob {
@@ -15,13 +25,41 @@ struct PoolJob {
     std::string header;
     std::string target;
     uint32_t height = 0;
-    double difficulty = 1.0;  // Store pool difficulty
+    double difficulty = 0.0;  // Share difficulty, from mining.set_difficulty or the notify target
+    bool has_difficulty = false;  // mining.set_difficulty seen; it overrides the notify target
     std::vector<uint8_t> share_target_bytes; // Store pool share target as 32-byte little-endian
+    uint64_t generation = 0;  // Bumped on every notify so in-flight work can detect job switches
+    uint64_t target_epoch = 0;  // Bumped whenever share_target_bytes changes
+    std::chrono::steady_clock::time_point notified_at;  // When the current job arrived
+    NonceSpace nonces;        // Extranonce prefix and worker range for this connection
+    std::vector<std::string> live_jobs;  // Jobs the pool still takes shares for, newest last; reset by clean_jobs
     std::atomic<bool> active{false};
     std::mutex mtx;
     std::condition_variable cv;
 };
 
+// Counters kept by the mining thread, stable once run() returns
+struct SessionStats {
+    uint64_t job_switches = 0;         // Jobs the mining thread started work on
+    double switch_latency_ms_sum = 0;  // Notify arrival to first batch dispatched on the job
+    double switch_latency_ms_max = 0;
+    uint64_t stale_batches = 0;        // Batches that finished after their job was replaced
+    uint64_t stale_nonces = 0;
+    uint64_t shares_submitted = 0;
+    uint64_t bad_candidates = 0;       // Candidates dropped by pre-submit verification
+    uint64_t below_target = 0;         // Candidates that missed a share target raised mid-batch
+    uint64_t difficulty_suggestions = 0;
+};
+
+// Settings a config reload changes while the miner runs
+struct LiveTuning {
+    bool retune = false;      // Apply threads, interleave and isa to the engine
+    int threads = 0;          // Active worker threads, 0 = all
+    uint32_t interleave = 0;  // 0 = engine default
+    std::string isa;          // Empty = best available
+    uint32_t batch_ms = 0;    // Batch wall-time target, 0 = unchanged
+};
+
 class StratumClient {
 public:
     StratumClient(const std::string& host,
@@ -35,26 +73,125 @@ public:
     // Main mining loop (blocks until exit)
     void run();
 
+    // Runs a single session over an already-connected socket, without
+    // reconnecting. Used to replay recorded sessions.
+    void run_on_socket(int fd);
+
     // Used by GPU thread to get current job
     PoolJob& getCurrentJob();
 
     // Used to signal threads to exit
     void stop();
 
+    // Hashing engine driven by the mining thread (not owned)
+    void set_engine(autolykos2_engine* engine);
+
+    // Hashing waits for ready, e.g. a dataset still building, while the
+    // session connects and the latest job is held. false stops the client.
+    void set_engine_ready(std::shared_future<bool> ready);
+
+    // Target wall-time per nonce batch, used to size batches to the engine
+    void set_batch_target_ms(uint32_t ms);
+
+    // Engine and batch settings from a config reload. They are handed to
+    // the mining thread, which applies them between batches and rebases
+    // the governor on them; updates not yet applied are merged.
+    void set_live_tuning(const LiveTuning& tuning);
+
+    // Switches pool or credentials at runtime. The current session is
+    // dropped and the client reconnects immediately with the new settings.
+    void set_pool(const std::string& host,
+                  int port,
+                  bool ssl,
+                  const std::string& worker,
+                  const std::string& password,
+                  const std::string& address);
+
+    // Recompute every candidate on the CPU before submitting it (default on)
+    void set_verify_shares(bool verify);
+
+    // Records all Stratum traffic to recorder (not owned, may be NULL)
+    void set_recorder(SessionRecorder* recorder);
+
+    // Reserves the top worker_bits of the pool's extranonce2 for worker_id,
+    // so miners sharing one extranonce1 (e.g. behind a proxy) scan disjoint
+    // ranges. Returns false if the ID does not fit.
+    bool set_worker_id(uint32_t worker_id, uint32_t worker_bits);
+
+    // Suggests pool difficulty to hold the share rate inside a band
+    void set_share_rate(const ShareRateConfig& config);
+
+    // Most found shares held while waiting for an answer or a connection
+    void set_share_queue_size(size_t size);
+
+    // Rolling window of the share statistics, and where the periodic
+    // report writes them as JSON (empty = log only)
+    void set_share_stats(double window_s, const std::string& metrics_file);
+
+    // Lets governor retune threads, duty cycle and batch length (not owned, may be NULL)
+    void set_governor(EfficiencyGovernor* governor);
+
+    const SessionStats& session_stats() const;
+    ShareQueueStats share_queue_stats() const;
+
 private:
     // Connection and protocol helpers
     bool connect();
+    void close_socket();
+    void run_session();
     void subscribe();
     void authorize();
     void listen();
     void handle_message(const nlohmann::json& msg);
-    void send_json(const nlohmann::json& j);
+    void set_extranonce(const std::string& extranonce1, int extranonce2_size);
+    void set_difficulty(double difficulty);
+    void suggest_difficulty(double difficulty, double rate_per_min);
+    bool send_json(const nlohmann::json& j);
 
     // Mining helpers
+    struct JobSnapshot {
+        uint64_t generation = 0;
+        std::string job_id;
+        uint32_t height = 0;
+        uint8_t header[76] = {0};
+        uint8_t target[32] = {0};
+        uint64_t target_epoch = 0;
+        double difficulty = 0.0;
+        std::chrono::steady_clock::time_point notified_at;
+        NonceSpace nonces;
+    };
+    struct BatchResult {
+        uint64_t generation = 0;
+        std::string job_id;
+        uint8_t header[76] = {0};  // Header and nonce range of the batch's job, kept
+        NonceSpace nonces;         // for the pre-submit check after a job switch
+        uint64_t start_nonce = 0;
+        uint32_t nonce_count = 0;
+        uint8_t target[32] = {0};  // Share target the batch was mined against
+        double difficulty = 0.0;   // Share difficulty of that target
+        bool ok = false;
+        bool found = false;
+        uint64_t nonce = 0;
+        uint8_t hash[32] = {0};
+        double seconds = 0.0;
+    };
     void mining_thread();
+    bool wait_for_engine();
+    bool wait_for_job(JobSnapshot& snap);
+    bool wait_for_new_job(JobSnapshot& snap);
+    bool refresh_job(JobSnapshot& snap);
+    BatchResult run_batch(const JobSnapshot& snap, uint64_t start_nonce, uint32_t nonce_count);
+    void note_job_switch(const JobSnapshot& snap);
+    void print_telemetry();
+    void report_shares();
+    bool verify_candidate(const BatchResult& done, uint8_t* hash);
+    void check_candidate(const JobSnapshot& snap, const BatchResult& done);
+    bool batch_live(const BatchResult& done);
+    void apply_live_tuning();
 
     // Submission helpers
-    void submit_share(const std::string& nonce_hex, const std::string& pow_hash);
+    void flush_shares(const std::vector<std::string>& jobs, const NonceSpace& nonces);
+    bool submit_share(const PendingShare& share);
 
     // Logging
     void logline(const std::string& msg);
@@ -68,10 +205,28 @@ private:
     std::string password_;
     std::string address_;
 
-    int sock_;
+    std::mutex settings_mtx_;  // Guards the connection settings above
+    std::mutex send_mtx_;      // Keeps lines from the listener and mining threads whole
+    std::atomic<int> sock_;    // Assigned and closed under settings_mtx_
     std::atomic<bool> running_;
+    std::atomic<bool> session_up_{false};  // Cleared when the current connection ends
+    std::atomic<bool> reconnect_{false};   // Session dropped on purpose by set_pool
     std::thread listener_;
     std::thread miner_;
 
     PoolJob current_job_;
+
+    autolykos2_engine* engine_ = nullptr;
+    std::shared_future<bool> engine_ready_;
+    std::atomic<uint32_t> batch_target_ms_{250};
+    std::atomic<bool> verify_shares_{true};
+    SessionRecorder* recorder_ = nullptr;
+    EfficiencyGovernor* governor_ = nullptr;
+    ShareRateController share_rate_{ShareRateConfig()};
+    ShareQueue shares_;
+    ShareStats share_stats_;
+    std::string metrics_file_;  // Guarded by settings_mtx_
+    LiveTuning live_tuning_;    // Guarded by settings_mtx_, waiting for the mining thread
+    bool live_tuning_pending_ = false;
+    SessionStats stats_;
 };
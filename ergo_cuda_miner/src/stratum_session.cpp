@@ -0,0 +1,127 @@
+// stratum_session.cpp
+#include "stratum_session.h"
+#include "stratum_client.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char* kSessionMagic = "# cortex-stratum-session v1";
+
+bool SessionRecorder::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    out_.open(path, std::ios::out | std::ios::trunc);
+    if (!out_.is_open()) {
+        std::cerr << "[SESSION] Cannot open " << path << " for recording" << std::endl;
+        return false;
+    }
+    out_ << kSessionMagic << "\n";
+    start_ = std::chrono::steady_clock::now();
+    std::cout << "[SESSION] Recording Stratum traffic to " << path << std::endl;
+    return true;
+}
+
+void SessionRecorder::record(char dir, const std::string& line) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!out_.is_open()) return;
+    uint64_t t_us = std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count();
+    // Flushed per line so a crashed session still leaves a usable recording
+    out_ << t_us << ' ' << dir << ' ' << line << std::endl;
+}
+
+bool load_session(const std::string& path, std::vector<SessionEvent>& events) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "[SESSION] Cannot open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != kSessionMagic) {
+        std::cerr << "[SESSION] " << path << " is not a recorded session" << std::endl;
+        return false;
+    }
+    events.clear();
+    size_t lineno = 1;
+    while (std::getline(in, line)) {
+        ++lineno;
+        if (line.empty()) continue;
+        std::istringstream ss(line);
+        SessionEvent ev;
+        if (!(ss >> ev.t_us >> ev.dir) || (ev.dir != '<' && ev.dir != '>') || ss.get() != ' ') {
+            std::cerr << "[SESSION] Malformed event at " << path << ":" << lineno << std::endl;
+            return false;
+        }
+        std::getline(ss, ev.line);
+        events.push_back(std::move(ev));
+    }
+    return true;
+}
+
+static double cpu_seconds() {
+    struct rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+bool replay_session(StratumClient& client, const std::vector<SessionEvent>& events,
+                    double speed, ReplayReport& report) {
+    std::vector<const SessionEvent*> pool_side;
+    for (const auto& ev : events) {
+        if (ev.dir == '<') pool_side.push_back(&ev);
+    }
+    if (pool_side.empty()) {
+        std::cerr << "[REPLAY] Session has no pool traffic" << std::endl;
+        return false;
+    }
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        std::cerr << "[REPLAY] socketpair failed" << std::endl;
+        return false;
+    }
+
+    report = ReplayReport{};
+    const double cpu_start = cpu_seconds();
+    const auto wall_start = std::chrono::steady_clock::now();
+
+    // Pool side: deliver recorded lines on schedule, then half-close so the
+    // client's listener sees end of stream once the last job has run a while
+    std::thread feeder([&] {
+        const uint64_t base_us = pool_side.front()->t_us;
+        for (const SessionEvent* ev : pool_side) {
+            if (speed > 0) {
+                auto offset = std::chrono::microseconds((uint64_t)((ev->t_us - base_us) / speed));
+                std::this_thread::sleep_until(wall_start + offset);
+            }
+            std::string data = ev->line + "\n";
+            if (send(fds[1], data.data(), data.size(), MSG_NOSIGNAL) < 0) break;
+            report.pool_lines++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        shutdown(fds[1], SHUT_WR);
+    });
+    // Miner side traffic (subscribe, authorize, submits) is read and dropped
+    std::thread drain([&] {
+        char buf[4096];
+        while (recv(fds[1], buf, sizeof(buf), 0) > 0) {}
+    });
+
+    client.run_on_socket(fds[0]);
+    feeder.join();
+    drain.join();
+    close(fds[1]);
+
+    const SessionStats& stats = client.session_stats();
+    report.job_switches = stats.job_switches;
+    report.switch_latency_avg_ms = stats.job_switches ? stats.switch_latency_ms_sum / stats.job_switches : 0.0;
+    report.switch_latency_max_ms = stats.switch_latency_ms_max;
+    report.stale_batches = stats.stale_batches;
+    report.stale_nonces = stats.stale_nonces;
+    report.shares_submitted = stats.shares_submitted;
+    report.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    report.cpu_seconds = cpu_seconds() - cpu_start;
+    return true;
+}
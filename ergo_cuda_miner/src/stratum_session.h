@@ -0,0 +1,61 @@
+// stratum_session.h
+#ifndef STRATUM_SESSION_H
+#define STRATUM_SESSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class StratumClient;
+
+// One Stratum line as seen by the client. dir is '<' for pool-to-miner and
+// '>' for miner-to-pool; t_us is microseconds since the session started.
+struct SessionEvent {
+    uint64_t t_us = 0;
+    char dir = '<';
+    std::string line;
+};
+
+// Appends raw Stratum traffic to a session file, one event per line:
+//   # cortex-stratum-session v1
+//   <t_us> <dir> <raw json line>
+// Safe to call from the listener and mining threads at once.
+class SessionRecorder {
+public:
+    bool open(const std::string& path);
+    void record(char dir, const std::string& line);
+    bool is_open() const { return out_.is_open(); }
+
+private:
+    std::mutex mtx_;
+    std::ofstream out_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Reads a session file written by SessionRecorder
+bool load_session(const std::string& path, std::vector<SessionEvent>& events);
+
+struct ReplayReport {
+    uint64_t pool_lines = 0;        // Pool lines fed to the client
+    uint64_t job_switches = 0;      // Jobs the mining thread switched to
+    double switch_latency_avg_ms = 0.0;
+    double switch_latency_max_ms = 0.0;
+    uint64_t stale_batches = 0;     // Batches finished after their job was replaced
+    uint64_t stale_nonces = 0;
+    uint64_t shares_submitted = 0;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;       // Process user + system time during the replay
+};
+
+// Feeds the pool side of a recorded session back through client over a
+// local socket pair, no network involved. Pool lines are delivered at their
+// recorded offsets divided by speed (speed <= 0 sends them back to back).
+// The client's own traffic is read and discarded. Returns false if the
+// session holds no pool traffic.
+bool replay_session(StratumClient& client, const std::vector<SessionEvent>& events,
+                    double speed, ReplayReport& report);
+
+#endif // STRATUM_SESSION_H
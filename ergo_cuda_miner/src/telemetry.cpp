@@ -0,0 +1,320 @@
+// telemetry.cpp
+#include "telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <dlfcn.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static_assert(sizeof(TelemetrySnapshot) % sizeof(uint64_t) == 0,
+              "TelemetrySnapshot is published as whole 64-bit words");
+
+static bool read_u64(const std::string& path, uint64_t& value) {
+    std::ifstream f(path);
+    return static_cast<bool>(f >> value);
+}
+
+static std::string read_line(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------- sysfs backend ----------
+
+class SysfsTelemetry : public TelemetryBackend {
+public:
+    SysfsTelemetry() {
+        find_temp_sensors();
+        find_cpufreq();
+        find_rapl();
+    }
+
+    const char* name() const override { return "sysfs"; }
+
+    void sample(TelemetrySnapshot& snap, double dt_s) override {
+        uint64_t v;
+        double hottest = -1e9;
+        for (const auto& path : temp_files_) {
+            if (read_u64(path, v)) hottest = std::max(hottest, v / 1000.0);
+        }
+        if (hottest > -1e9) {
+            snap.cpu_temp_c = hottest;
+            snap.flags |= kTelemetryCpuTemp;
+        }
+
+        double khz = 0.0;
+        size_t n = 0;
+        for (const auto& path : freq_files_) {
+            if (read_u64(path, v)) { khz += v; ++n; }
+        }
+        if (n) {
+            snap.cpu_mhz = khz / n / 1000.0;
+            snap.flags |= kTelemetryCpuFreq;
+        }
+
+        sample_util(snap);
+
+        // RAPL counters are cumulative microjoules that wrap at max_energy_range_uj
+        double joules = 0.0;
+        bool have_energy = false;
+        for (auto& d : rapl_) {
+            if (!read_u64(d.energy_path, v)) continue;
+            if (d.primed) {
+                uint64_t delta = v >= d.last ? v - d.last : d.range - d.last + v;
+                joules += delta / 1e6;
+                have_energy = true;
+            }
+            d.last = v;
+            d.primed = true;
+        }
+        if (have_energy) {
+            energy_j_ += joules;
+            snap.cpu_energy_j = energy_j_;
+            if (dt_s > 0) {
+                snap.cpu_power_w = joules / dt_s;
+                snap.flags |= kTelemetryCpuPower;
+            }
+        }
+    }
+
+private:
+    struct RaplDomain {
+        std::string energy_path;
+        uint64_t range = 0;
+        uint64_t last = 0;
+        bool primed = false;
+    };
+
+    void find_temp_sensors() {
+        // Prefer CPU package sensors; fall back to every thermal zone
+        static const char* cpu_chips[] = {"coretemp", "k10temp", "zenpower", "cpu_thermal"};
+        std::error_code ec;
+        for (const auto& dir : fs::directory_iterator("/sys/class/hwmon", ec)) {
+            std::string chip = read_line(dir.path() / "name");
+            if (std::find(std::begin(cpu_chips), std::end(cpu_chips), chip) == std::end(cpu_chips)) continue;
+            for (const auto& f : fs::directory_iterator(dir.path(), ec)) {
+                std::string file = f.path().filename();
+                if (file.rfind("temp", 0) == 0 && file.size() > 6 &&
+                    file.compare(file.size() - 6, 6, "_input") == 0) {
+                    temp_files_.push_back(f.path());
+                }
+            }
+        }
+        if (!temp_files_.empty()) return;
+        for (const auto& dir : fs::directory_iterator("/sys/class/thermal", ec)) {
+            if (dir.path().filename().string().rfind("thermal_zone", 0) == 0)
+                temp_files_.push_back(dir.path() / "temp");
+        }
+    }
+
+    void find_cpufreq() {
+        std::error_code ec;
+        for (const auto& dir : fs::directory_iterator("/sys/devices/system/cpu", ec)) {
+            fs::path f = dir.path() / "cpufreq" / "scaling_cur_freq";
+            if (fs::exists(f, ec)) freq_files_.push_back(f);
+        }
+    }
+
+    void find_rapl() {
+        // Top-level domains (intel-rapl:N) are packages; intel-rapl:N:M are
+        // subdomains already counted in their package
+        std::error_code ec;
+        for (const auto& dir : fs::directory_iterator("/sys/class/powercap", ec)) {
+            std::string name = dir.path().filename();
+            if (name.rfind("intel-rapl:", 0) != 0 || name.find(':', 11) != std::string::npos) continue;
+            RaplDomain d;
+            d.energy_path = dir.path() / "energy_uj";
+            if (!read_u64(dir.path() / "max_energy_range_uj", d.range)) continue;
+            uint64_t probe;
+            if (!read_u64(d.energy_path, probe)) continue;  // Usually root-only
+            rapl_.push_back(d);
+        }
+    }
+
+    void sample_util(TelemetrySnapshot& snap) {
+        std::istringstream ss(read_line("/proc/stat"));
+        std::string cpu;
+        uint64_t user, nice, system, idle, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        if (!(ss >> cpu >> user >> nice >> system >> idle)) return;
+        ss >> iowait >> irq >> softirq >> steal;
+        uint64_t idle_all = idle + iowait;
+        uint64_t total = user + nice + system + idle_all + irq + softirq + steal;
+        if (last_total_ && total > last_total_) {
+            double busy = (double)(total - last_total_) - (double)(idle_all - last_idle_);
+            snap.cpu_util = 100.0 * busy / (double)(total - last_total_);
+            snap.flags |= kTelemetryCpuUtil;
+        }
+        last_total_ = total;
+        last_idle_ = idle_all;
+    }
+
+    std::vector<std::string> temp_files_;
+    std::vector<std::string> freq_files_;
+    std::vector<RaplDomain> rapl_;
+    double energy_j_ = 0.0;
+    uint64_t last_total_ = 0;
+    uint64_t last_idle_ = 0;
+};
+
+std::unique_ptr<TelemetryBackend> make_sysfs_telemetry() {
+    return std::unique_ptr<TelemetryBackend>(new SysfsTelemetry());
+}
+
+// ---------- NVML backend ----------
+
+// Minimal slice of the NVML ABI, so no CUDA toolkit headers are needed
+typedef int nvmlReturn_t;
+typedef struct nvmlDevice_st* nvmlDevice_t;
+struct nvmlUtilization_t { unsigned int gpu; unsigned int memory; };
+static const int NVML_TEMPERATURE_GPU = 0;
+
+class NvmlTelemetry : public TelemetryBackend {
+public:
+    ~NvmlTelemetry() override {
+        if (shutdown_) shutdown_();
+        if (lib_) dlclose(lib_);
+    }
+
+    bool init(int device) {
+        lib_ = dlopen("libnvidia-ml.so.1", RTLD_NOW);
+        if (!lib_) return false;
+        auto init = (nvmlReturn_t (*)())dlsym(lib_, "nvmlInit_v2");
+        auto get_handle = (nvmlReturn_t (*)(unsigned int, nvmlDevice_t*))dlsym(lib_, "nvmlDeviceGetHandleByIndex_v2");
+        shutdown_ = (nvmlReturn_t (*)())dlsym(lib_, "nvmlShutdown");
+        get_temp_ = (nvmlReturn_t (*)(nvmlDevice_t, int, unsigned int*))dlsym(lib_, "nvmlDeviceGetTemperature");
+        get_power_ = (nvmlReturn_t (*)(nvmlDevice_t, unsigned int*))dlsym(lib_, "nvmlDeviceGetPowerUsage");
+        get_util_ = (nvmlReturn_t (*)(nvmlDevice_t, nvmlUtilization_t*))dlsym(lib_, "nvmlDeviceGetUtilizationRates");
+        if (!init || !get_handle || !shutdown_ || !get_temp_ || !get_power_ || !get_util_) return false;
+        if (init() != 0) {
+            shutdown_ = nullptr;
+            return false;
+        }
+        return get_handle((unsigned int)device, &device_) == 0;
+    }
+
+    const char* name() const override { return "nvml"; }
+
+    void sample(TelemetrySnapshot& snap, double dt_s) override {
+        unsigned int temp, milliwatts;
+        nvmlUtilization_t util;
+        if (get_temp_(device_, NVML_TEMPERATURE_GPU, &temp) == 0) {
+            snap.device_temp_c = temp;
+            snap.flags |= kTelemetryDeviceTemp;
+        }
+        if (get_power_(device_, &milliwatts) == 0) {
+            snap.device_power_w = milliwatts / 1000.0;
+            snap.flags |= kTelemetryDevicePower;
+            energy_j_ += snap.device_power_w * dt_s;
+        }
+        snap.device_energy_j = energy_j_;
+        if (get_util_(device_, &util) == 0) {
+            snap.device_util = util.gpu;
+            snap.flags |= kTelemetryDeviceUtil;
+        }
+    }
+
+private:
+    void* lib_ = nullptr;
+    nvmlDevice_t device_ = nullptr;
+    nvmlReturn_t (*shutdown_)() = nullptr;
+    nvmlReturn_t (*get_temp_)(nvmlDevice_t, int, unsigned int*) = nullptr;
+    nvmlReturn_t (*get_power_)(nvmlDevice_t, unsigned int*) = nullptr;
+    nvmlReturn_t (*get_util_)(nvmlDevice_t, nvmlUtilization_t*) = nullptr;
+    double energy_j_ = 0.0;
+};
+
+std::unique_ptr<TelemetryBackend> make_nvml_telemetry(int device) {
+    std::unique_ptr<NvmlTelemetry> nvml(new NvmlTelemetry());
+    if (!nvml->init(device)) return nullptr;
+    return std::unique_ptr<TelemetryBackend>(nvml.release());
+}
+
+// ---------- Sampler ----------
+
+TelemetrySampler::~TelemetrySampler() {
+    stop();
+}
+
+void TelemetrySampler::add_backend(std::unique_ptr<TelemetryBackend> backend) {
+    if (backend) backends_.push_back(std::move(backend));
+}
+
+void TelemetrySampler::start(uint32_t interval_ms) {
+    if (thread_.joinable()) return;
+    stop_ = false;
+    std::string names;
+    for (const auto& b : backends_) names += std::string(names.empty() ? "" : ", ") + b->name();
+    std::cout << "[TELEMETRY] Sampling every " << interval_ms << " ms ("
+              << (names.empty() ? "no backends" : names) << ")" << std::endl;
+    thread_ = std::thread(&TelemetrySampler::run, this, interval_ms ? interval_ms : 1);
+}
+
+void TelemetrySampler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void TelemetrySampler::run(uint32_t interval_ms) {
+    uint64_t seq = 0;
+    double last = 0.0;
+    auto next = std::chrono::steady_clock::now();
+    for (;;) {
+        TelemetrySnapshot snap;
+        snap.time_s = now_seconds();
+        snap.seq = ++seq;
+        double dt = last > 0.0 ? snap.time_s - last : 0.0;
+        last = snap.time_s;
+        for (auto& b : backends_) b->sample(snap, dt);
+        publish(snap);
+
+        next += std::chrono::milliseconds(interval_ms);
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (cv_.wait_until(lock, next, [this] { return stop_; })) return;
+    }
+}
+
+// Single writer: the version is odd while the words are being replaced
+void TelemetrySampler::publish(const TelemetrySnapshot& snap) {
+    uint64_t words[kWords];
+    memcpy(words, &snap, sizeof(words));
+    uint64_t v = version_.load(std::memory_order_relaxed);
+    version_.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) words_[i].store(words[i], std::memory_order_relaxed);
+    version_.store(v + 2, std::memory_order_release);
+}
+
+TelemetrySnapshot TelemetrySampler::snapshot() const {
+    uint64_t words[kWords];
+    for (;;) {
+        uint64_t v1 = version_.load(std::memory_order_acquire);
+        if (v1 & 1) continue;
+        for (size_t i = 0; i < kWords; ++i) words[i] = words_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) == v1) break;
+    }
+    TelemetrySnapshot snap;
+    memcpy(&snap, words, sizeof(snap));
+    return snap;
+}
+
+TelemetrySampler& telemetry() {
+    static TelemetrySampler sampler;
+    return sampler;
+}
@@ -0,0 +1,89 @@
+// telemetry.h
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum TelemetryFlags : uint32_t {
+    kTelemetryCpuTemp     = 1u << 0,
+    kTelemetryCpuFreq     = 1u << 1,
+    kTelemetryCpuUtil     = 1u << 2,
+    kTelemetryCpuPower    = 1u << 3,
+    kTelemetryDeviceTemp  = 1u << 4,
+    kTelemetryDevicePower = 1u << 5,
+    kTelemetryDeviceUtil  = 1u << 6,
+};
+
+// One sample of every backend. A field is only meaningful when its flag is set.
+struct TelemetrySnapshot {
+    uint64_t seq = 0;            // Sample number, 0 = nothing sampled yet
+    double time_s = 0.0;         // steady_clock seconds when the sample was taken
+    uint32_t flags = 0;          // TelemetryFlags
+    uint32_t reserved = 0;
+    double cpu_temp_c = 0.0;     // Hottest CPU sensor
+    double cpu_mhz = 0.0;        // Mean current frequency over online CPUs
+    double cpu_util = 0.0;       // Percent busy over all CPUs since the last sample
+    double cpu_power_w = 0.0;    // RAPL package power, all sockets
+    double cpu_energy_j = 0.0;   // RAPL package energy since the sampler started
+    double device_temp_c = 0.0;
+    double device_power_w = 0.0;
+    double device_util = 0.0;
+    double device_energy_j = 0.0; // Integrated device power since the sampler started
+};
+
+// A telemetry source. sample() runs on the sampler thread only.
+class TelemetryBackend {
+public:
+    virtual ~TelemetryBackend() = default;
+    virtual const char* name() const = 0;
+    // Fills the fields this backend owns and sets their flags. dt_s is the
+    // time since the previous call, 0 on the first one.
+    virtual void sample(TelemetrySnapshot& snap, double dt_s) = 0;
+};
+
+// hwmon/thermal temperatures, cpufreq, /proc/stat utilization and RAPL energy
+std::unique_ptr<TelemetryBackend> make_sysfs_telemetry();
+
+// NVIDIA device through libnvidia-ml, loaded at runtime. Returns NULL when
+// the library or the device is not available.
+std::unique_ptr<TelemetryBackend> make_nvml_telemetry(int device);
+
+// Samples its backends on a fixed interval and publishes the result through
+// a seqlock, so snapshot() never blocks and never takes a lock.
+class TelemetrySampler {
+public:
+    ~TelemetrySampler();
+
+    // Backends must be added before start()
+    void add_backend(std::unique_ptr<TelemetryBackend> backend);
+    void start(uint32_t interval_ms);
+    void stop();
+
+    // Latest published sample (seq == 0 before the first one)
+    TelemetrySnapshot snapshot() const;
+
+private:
+    void run(uint32_t interval_ms);
+    void publish(const TelemetrySnapshot& snap);
+
+    static constexpr size_t kWords = sizeof(TelemetrySnapshot) / sizeof(uint64_t);
+    std::atomic<uint64_t> version_{0};      // Odd while a sample is being written
+    std::atomic<uint64_t> words_[kWords] = {};
+
+    std::vector<std::unique_ptr<TelemetryBackend>> backends_;
+    std::thread thread_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+// Process-wide sampler shared by the miner, loggers and advisors
+TelemetrySampler& telemetry();
+
+#endif // TELEMETRY_H
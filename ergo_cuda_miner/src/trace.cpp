@@ -0,0 +1,240 @@
+// trace.cpp
+#include "trace.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+#ifndef CORTEX_NO_TRACE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Events per thread; the oldest are overwritten once a ring wraps
+static constexpr uint32_t kRingSize = 1u << 14;
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t dur;   // 0 for instant events
+    uint64_t arg;
+};
+
+// Written only by its owning thread. head counts events ever recorded and is
+// published with release so a dump sees fully written slots.
+struct ThreadRing {
+    TraceEvent events[kRingSize];
+    std::atomic<uint64_t> head{0};
+    const char* name = nullptr;
+    uint32_t tid = 0;
+    bool in_use = false;
+};
+
+// Rings outlive their threads so short-lived workers still show up in a
+// dump; a retired ring is handed to the next new thread.
+struct Registry {
+    std::mutex mtx;
+    std::vector<ThreadRing*> rings;
+    uint64_t tsc0;
+    std::chrono::steady_clock::time_point wall0;
+
+    Registry() : tsc0(trace_now()), wall0(std::chrono::steady_clock::now()) {}
+};
+
+Registry& registry() {
+    static Registry* r = new Registry();  // Never destroyed: threads may trace during exit
+    return *r;
+}
+
+// Pins the timestamp origin at startup rather than at the first trace point
+const Registry& g_registry_init = registry();
+
+struct RingHolder {
+    ThreadRing* ring = nullptr;
+
+    ~RingHolder() {
+        if (!ring) return;
+        std::lock_guard<std::mutex> lock(registry().mtx);
+        ring->in_use = false;
+    }
+};
+
+thread_local RingHolder t_holder;
+
+ThreadRing* acquire_ring() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    for (ThreadRing* r : reg.rings) {
+        if (!r->in_use) {
+            r->in_use = true;
+            r->name = nullptr;
+            return r;
+        }
+    }
+    ThreadRing* r = new ThreadRing();
+    r->tid = (uint32_t)reg.rings.size() + 1;
+    r->in_use = true;
+    reg.rings.push_back(r);
+    return r;
+}
+
+inline ThreadRing* my_ring() {
+    if (!t_holder.ring) t_holder.ring = acquire_ring();
+    return t_holder.ring;
+}
+
+inline void record(const char* name, uint64_t start, uint64_t dur, uint64_t arg) {
+    ThreadRing* r = my_ring();
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    r->events[h & (kRingSize - 1)] = {name, start, dur, arg};
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void write_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+} // namespace
+
+uint64_t trace_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void trace_complete(const char* name, uint64_t start, uint64_t arg) {
+    uint64_t now = trace_now();
+    record(name, start, now > start ? now - start : 1, arg);
+}
+
+void trace_instant(const char* name, uint64_t arg) {
+    record(name, trace_now(), 0, arg);
+}
+
+void trace_set_thread_name(const char* name) {
+    ThreadRing* r = my_ring();
+    std::lock_guard<std::mutex> lock(registry().mtx);
+    r->name = name;
+}
+
+bool trace_dump(const std::string& path) {
+    Registry& reg = registry();
+
+    // Ticks per microsecond over the span since startup
+    uint64_t tsc1 = trace_now();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - reg.wall0).count();
+    double ticks_per_us = us > 0.0 && tsc1 > reg.tsc0 ? (tsc1 - reg.tsc0) / us : 1000.0;
+
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "[TRACE] Cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<ThreadRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        rings = reg.rings;
+    }
+
+    size_t count = 0;
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (ThreadRing* r : rings) {
+        const char* name;
+        {
+            std::lock_guard<std::mutex> lock(reg.mtx);
+            name = r->name;
+        }
+        if (name) {
+            fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",\n", r->tid);
+            write_json_string(f, name);
+            fprintf(f, "}}");
+            first = false;
+        }
+
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t begin = head > kRingSize ? head - kRingSize : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            TraceEvent ev = r->events[i & (kRingSize - 1)];
+            if (!ev.name || ev.start < reg.tsc0) continue;
+            double ts = (ev.start - reg.tsc0) / ticks_per_us;
+            fprintf(f, "%s{\"name\":", first ? "" : ",\n");
+            write_json_string(f, ev.name);
+            if (ev.dur) {
+                fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", ts, ev.dur / ticks_per_us);
+            } else {
+                fprintf(f, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", ts);
+            }
+            fprintf(f, ",\"pid\":1,\"tid\":%u,\"args\":{\"v\":%llu}}", r->tid, (unsigned long long)ev.arg);
+            first = false;
+            ++count;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = !ferror(f);
+    fclose(f);
+    printf("[TRACE] Wrote %zu events from %zu threads to %s\n", count, rings.size(), path.c_str());
+    return ok;
+}
+
+#else
+
+bool trace_dump(const std::string& path) {
+    fprintf(stderr, "[TRACE] Built without tracing, not writing %s\n", path.c_str());
+    return false;
+}
+
+#endif // CORTEX_NO_TRACE
+
+// SIGUSR1 is turned into a byte on this pipe and the dump runs on a
+// background thread, since nothing in trace_dump is async-signal-safe
+static int g_usr1_pipe[2] = {-1, -1};
+
+static void on_sigusr1(int) {
+    int saved = errno;
+    char b = 1;
+    (void)!write(g_usr1_pipe[1], &b, 1);
+    errno = saved;
+}
+
+void trace_dump_on_signal(const std::string& path) {
+    if (g_usr1_pipe[0] >= 0) return;
+    if (pipe2(g_usr1_pipe, O_CLOEXEC) < 0) return;
+
+    std::thread([path]() {
+        char b;
+        for (;;) {
+            ssize_t n = read(g_usr1_pipe[0], &b, 1);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            trace_dump(path);
+        }
+    }).detach();
+
+    struct sigaction sa{};
+    sa.sa_handler = on_sigusr1;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, nullptr);
+    printf("[TRACE] Send SIGUSR1 to write a trace to %s\n", path.c_str());
+}
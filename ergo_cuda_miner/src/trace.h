@@ -0,0 +1,64 @@
+// trace.h
+//
+// Hot-path trace points recorded into per-thread ring buffers and exported
+// as Chrome trace-event JSON (chrome://tracing, Perfetto). Building with
+// -DCORTEX_NO_TRACE (make TRACE=0) compiles every trace point away.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+#ifndef CORTEX_NO_TRACE
+
+// Timestamp in CPU ticks (TSC on x86, steady-clock nanoseconds elsewhere)
+uint64_t trace_now();
+
+// Records a complete event [start, now) on the calling thread. name must be
+// a string literal or otherwise outlive the process.
+void trace_complete(const char* name, uint64_t start, uint64_t arg);
+
+// Records a zero-length event
+void trace_instant(const char* name, uint64_t arg);
+
+// Labels the calling thread in exported traces
+void trace_set_thread_name(const char* name);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, uint64_t arg = 0)
+        : name_(name), arg_(arg), start_(trace_now()) {}
+    ~TraceScope() { trace_complete(name_, start_, arg_); }
+    void set_arg(uint64_t arg) { arg_ = arg; }
+
+private:
+    const char* name_;
+    uint64_t arg_;
+    uint64_t start_;
+};
+
+#define TRACE_CAT2(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CAT(trace_scope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CAT(trace_scope_, __LINE__)(name, (uint64_t)(arg))
+#define TRACE_INSTANT(name, arg) trace_instant(name, (uint64_t)(arg))
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, arg) ((void)0)
+#define TRACE_INSTANT(name, arg) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif // CORTEX_NO_TRACE
+
+// Writes every buffered event to path as Chrome trace JSON. Events keep
+// being recorded meanwhile; the newest ones may be missing from the dump.
+// Returns false if the file cannot be written or tracing is compiled out.
+bool trace_dump(const std::string& path);
+
+// Dumps to path whenever the process receives SIGUSR1
+void trace_dump_on_signal(const std::string& path);
+
+#endif // TRACE_H
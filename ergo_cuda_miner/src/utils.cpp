@@ -1,5 +1,6 @@
 #include "utils.h"
 #include <gmp.h>
+#include <cstdlib>
 #include <cstring>
 #include <vector>
 #include <string>
@@ -24,3 +25,73 @@ std::vector<uint8_t> decimal_to_target_bytes(const std::string& decimal) {
     mpz_clear(num);
     return target;
 }
+
+std::vector<uint8_t> difficulty_to_target_bytes(double difficulty) {
+    mpz_t max;
+    mpz_init(max);
+    mpz_ui_pow_ui(max, 2, 256);
+    mpz_sub_ui(max, max, 1);
+
+    mpf_t q, d;
+    mpf_init2(q, 320);
+    mpf_init2(d, 320);
+    mpf_set_z(q, max);
+    mpf_set_d(d, difficulty > 0.0 ? difficulty : 1.0);
+    mpf_div(q, q, d);
+
+    mpz_t num;
+    mpz_init(num);
+    mpz_set_f(num, q);
+    if (mpz_cmp(num, max) > 0) mpz_set(num, max);
+
+    std::vector<uint8_t> target(32, 0);
+    size_t count = 0;
+    std::vector<uint8_t> raw(32, 0);
+    mpz_export(raw.data(), &count, 1, 1, 1, 0, num);
+    memcpy(target.data() + (32 - count), raw.data(), count);
+
+    mpz_clears(max, num, nullptr);
+    mpf_clears(q, d, nullptr);
+    return target;
+}
+
+double target_bytes_to_difficulty(const std::vector<uint8_t>& target) {
+    mpz_t num;
+    mpz_init(num);
+    mpz_import(num, target.size(), 1, 1, 1, 0, target.data());
+    if (mpz_sgn(num) == 0) {
+        mpz_clear(num);
+        return 0.0;
+    }
+    mpf_t q, t;
+    mpf_init2(q, 320);
+    mpf_init2(t, 320);
+    mpf_set_ui(q, 2);
+    mpf_pow_ui(q, q, 256);
+    mpf_sub_ui(q, q, 1);
+    mpf_set_z(t, num);
+    mpf_div(q, q, t);
+    double difficulty = mpf_get_d(q);
+    mpz_clear(num);
+    mpf_clears(q, t, nullptr);
+    return difficulty;
+}
+
+std::vector<uint8_t> hex_to_bytes(const std::string& hex) {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(hex.size() / 2);
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes.push_back(static_cast<uint8_t>(strtol(hex.substr(i, 2).c_str(), nullptr, 16)));
+    }
+    return bytes;
+}
+
+std::string bytes_to_hex(const uint8_t* data, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(len * 2, '0');
+    for (size_t i = 0; i < len; ++i) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0F];
+    }
+    return hex;
+}
@@ -1,10 +1,20 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 // Example utility: convert decimal string to 32-byte target
 std::vector<uint8_t> decimal_to_target_bytes(const std::string& decimal);
 
+// Pool difficulty <-> 32-byte big-endian share target, with
+// target = (2^256 - 1) / difficulty
+std::vector<uint8_t> difficulty_to_target_bytes(double difficulty);
+double target_bytes_to_difficulty(const std::vector<uint8_t>& target);
+
+// Hex helpers for Stratum fields
+std::vector<uint8_t> hex_to_bytes(const std::string& hex);
+std::string bytes_to_hex(const uint8_t* data, size_t len);
+
 #endif // UTILS_H